@@ -0,0 +1,817 @@
+// Synthetic virtual-call workload for measuring what a hook costs the target per call.
+//
+// Builds MAX_CLASSES concrete classes that share SHARED_METHODS base virtuals and override
+// MAX_METHODS of their own, then hammers them from N threads at varying stack depths.
+// Every mode runs the exact same call sequence, so the checksum doubles as a correctness check.
+//
+// Modes:
+//  unhooked - plain virtual calls, the baseline.
+//  count    - count-only hooks. On Windows these are Hooker's count-only stubs, elsewhere the same
+//             generated CountStub code is reached through the vtable slots. Each stub must count
+//             exactly the calls made to it and record a return address.
+//  capture  - full capture. On Windows these are the real Hooker hooks (MidHook + generic_hook + unwinder).
+//             Elsewhere it's an emulation of the same bookkeeping (clock, unwind, locked copy).
+//
+// On Windows the hooks go on the function bodies, one per unique function, so the shared base
+// methods are hooked once rather than once per class.
+//
+// It also times RateTracker's per-second aggregation and top-K selection over an hour's worth
+// of ticks with synthetic counters, checking the top K against a full sort.
+//
+// Every mode is run once per thread count, so scaling regressions show up as well.
+//
+// Usage: vtablemonitor-bench [--classes N] [--methods M] [--threads 1,2,4] [--depth D]
+//                            [--calls C] [--modes unhooked,count,capture] [--out results.json]
+//                            [--rate-hooks 1000,10000,100000] [--top-k K]
+//
+// Results are printed as JSON (or written to --out) for regression tracking.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include "Hooker.hpp"
+#include <unordered_set>
+#include <intrin.h>
+#define BENCH_NOINLINE __declspec(noinline)
+#define BENCH_RETURN_ADDRESS() _ReturnAddress()
+#else
+#include <execinfo.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define BENCH_NOINLINE __attribute__((noinline))
+#define BENCH_RETURN_ADDRESS() __builtin_return_address(0)
+#endif
+
+#include "CountStub.hpp"
+#include "RateTracker.hpp"
+
+namespace bench {
+constexpr size_t MAX_CLASSES = 32;
+constexpr size_t SHARED_METHODS = 4;
+constexpr size_t MAX_METHODS = 16;
+constexpr size_t SLOTS = SHARED_METHODS + MAX_METHODS;
+
+#define BENCH_SHARED_METHODS(X) X(0) X(1) X(2) X(3)
+#define BENCH_METHODS(X) X(0) X(1) X(2) X(3) X(4) X(5) X(6) X(7) X(8) X(9) X(10) X(11) X(12) X(13) X(14) X(15)
+
+#define BENCH_DEFINE_SHARED(i) virtual uint64_t shared##i(uint64_t x) { return mix(x, 0x1000 + i); }
+#define BENCH_DECLARE_METHOD(i) virtual uint64_t m##i(uint64_t x) = 0;
+#define BENCH_OVERRIDE_METHOD(i) uint64_t m##i(uint64_t x) override { return mix(x, (C << 8) | i); }
+#define BENCH_SHARED_POINTER(i) &Base::shared##i,
+#define BENCH_METHOD_POINTER(i) &Base::m##i,
+
+// No virtual destructor on purpose, so slot N is always the Nth declared virtual on both ABIs.
+class Base {
+public:
+    BENCH_SHARED_METHODS(BENCH_DEFINE_SHARED)
+    BENCH_METHODS(BENCH_DECLARE_METHOD)
+
+protected:
+    ~Base() = default;
+
+    static uint64_t mix(uint64_t x, uint64_t k) {
+        x ^= k;
+        x *= 0x9E3779B97F4A7C15ull;
+        return x ^ (x >> 29);
+    }
+};
+
+template<uint64_t C>
+class Derived final : public Base {
+public:
+    BENCH_METHODS(BENCH_OVERRIDE_METHOD)
+};
+
+using Method = uint64_t (Base::*)(uint64_t);
+using RawFn = uint64_t (*)(Base*, uint64_t);
+
+const std::array<Method, SLOTS> METHODS{
+    BENCH_SHARED_METHODS(BENCH_SHARED_POINTER)
+    BENCH_METHODS(BENCH_METHOD_POINTER)
+};
+
+template<size_t... Is>
+std::array<Base*, MAX_CLASSES> make_objects(std::index_sequence<Is...>) {
+    static std::tuple<Derived<Is>...> objects{};
+    return {&std::get<Is>(objects)...};
+}
+
+const auto OBJECTS = make_objects(std::make_index_sequence<MAX_CLASSES>{});
+
+uintptr_t* get_vtable(Base* obj) {
+    return *reinterpret_cast<uintptr_t**>(obj);
+}
+
+struct Config {
+    size_t classes{8};
+    size_t methods{8};
+    std::vector<size_t> thread_counts{1, 2, 4};
+    size_t threads{1}; // The thread count of the current run.
+    size_t depth{4};
+    size_t calls{2'000'000};
+    std::vector<std::string> modes{"unhooked", "count", "capture"};
+    std::string out{};
+    std::vector<size_t> rate_hooks{1000, 10000, 100000};
+    size_t top_k{16};
+};
+
+struct Result {
+    std::string mode{};
+    std::string implementation{};
+    size_t threads{};
+    double ns_per_call{};
+    double calls_per_second{};
+    double attach_ms{};
+    double detach_ms{};
+    size_t hooks{};
+    size_t bytes_per_hook{};
+    uint64_t checksum{};
+    uint64_t hooked_calls{};
+    bool verified{};
+};
+
+struct RateResult {
+    size_t hooks{};
+    size_t top_k{};
+    size_t ticks{};
+    double us_per_tick{};
+    double ns_per_hook{};
+    size_t bytes_per_hook{};
+    size_t survey_bytes_per_hook{};
+    bool verified{};
+};
+
+// A survey hooks every virtual function in a module and almost none of them ever get called.
+// Its rate tracker shouldn't cost more per hook than the survey's own stubs, counters and originals.
+constexpr size_t SURVEY_HOT_PERCENT = 1;
+constexpr size_t SURVEY_RATE_BUDGET = 32;
+
+#ifdef _WIN32
+// One hook per function rather than a Hooker per class. Every Derived<C> shares the Base::shared
+// bodies (and the linker may fold identical overrides), so a Hooker per class would stack one MidHook
+// per class on them. That runs generic_hook once per layer, and stacked hooks can only be removed
+// in the reverse of the order they went on.
+std::vector<std::shared_ptr<Hooker::Hook>> create_hooks(const Config& config) {
+    std::vector<std::shared_ptr<Hooker::Hook>> result{};
+    std::unordered_set<uintptr_t> seen{};
+
+    for (size_t c = 0; c < config.classes; ++c) {
+        auto vtable = get_vtable(OBJECTS[c]);
+
+        for (size_t s = 0; s < SHARED_METHODS + config.methods; ++s) {
+            if (seen.insert(vtable[s]).second) {
+                result.push_back(Hooker::create_hook(nullptr, vtable[s], s));
+            }
+        }
+    }
+
+    return result;
+}
+
+// Last on, first off.
+void destroy_hooks(std::vector<std::shared_ptr<Hooker::Hook>>& hooks) {
+    while (!hooks.empty()) {
+        hooks.pop_back();
+    }
+}
+#else
+// Hooker needs Win32, so elsewhere the hooks are reached by patching the vtable slots directly.
+// Emulated hooks. One per (class, slot), indexed by class * SLOTS + slot.
+struct alignas(64) EmulatedHook {
+    uintptr_t original{};
+    std::atomic<uint64_t> calls{};
+    std::atomic<uintptr_t> last_return_address{};
+    std::atomic<int64_t> last_call{};
+    std::atomic<int64_t> delta{};
+    std::shared_mutex mutex{};
+    std::vector<uintptr_t> callstack{};
+};
+
+std::array<EmulatedHook, MAX_CLASSES * SLOTS> g_emulated{};
+
+template<size_t K>
+struct CaptureThunk {
+    static uint64_t call(Base* self, uint64_t x) {
+        auto& hook = g_emulated[K];
+        hook.calls.fetch_add(1);
+        hook.last_return_address = reinterpret_cast<uintptr_t>(BENCH_RETURN_ADDRESS());
+
+        const auto now = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        hook.delta = now - hook.last_call.exchange(now);
+
+        std::array<void*, 128> frames{};
+        const auto count = backtrace(frames.data(), (int)frames.size());
+
+        {
+            std::unique_lock _{hook.mutex};
+            hook.callstack.clear();
+
+            for (int i = 0; i < count; ++i) {
+                hook.callstack.push_back(reinterpret_cast<uintptr_t>(frames[i]));
+            }
+        }
+
+        return reinterpret_cast<RawFn>(hook.original)(self, x);
+    }
+};
+
+template<template<size_t> class Thunk, size_t... Ks>
+constexpr auto make_thunks(std::index_sequence<Ks...>) {
+    return std::array<RawFn, sizeof...(Ks)>{&Thunk<Ks>::call...};
+}
+
+const auto CAPTURE_THUNKS = make_thunks<CaptureThunk>(std::make_index_sequence<MAX_CLASSES * SLOTS>{});
+
+void write_slot(uintptr_t* slot, uintptr_t value) {
+    // Left writable afterwards, we don't know what else shares the page.
+    const auto page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+    const auto page = (uintptr_t)slot & ~(page_size - 1);
+    mprotect((void*)page, page_size, PROT_READ | PROT_WRITE | PROT_EXEC);
+    *slot = value;
+}
+
+// Redirects every slot of every active class through the given thunk table.
+void attach_emulated(const Config& config, const std::array<RawFn, MAX_CLASSES * SLOTS>& thunks) {
+    for (size_t c = 0; c < config.classes; ++c) {
+        auto vtable = get_vtable(OBJECTS[c]);
+
+        for (size_t s = 0; s < SHARED_METHODS + config.methods; ++s) {
+            auto& hook = g_emulated[c * SLOTS + s];
+            hook.original = vtable[s];
+            hook.calls = 0;
+            hook.last_call = 0;
+            hook.callstack.clear();
+            write_slot(&vtable[s], (uintptr_t)thunks[c * SLOTS + s]);
+        }
+    }
+}
+
+void detach_emulated(const Config& config) {
+    for (size_t c = 0; c < config.classes; ++c) {
+        auto vtable = get_vtable(OBJECTS[c]);
+
+        for (size_t s = 0; s < SHARED_METHODS + config.methods; ++s) {
+            write_slot(&vtable[s], g_emulated[c * SLOTS + s].original);
+        }
+    }
+}
+
+// Count stubs, one per (class, slot) like g_emulated. The code lives in its own executable
+// mapping, the counters stay in ordinary data so they never share a page with the code.
+uint8_t* g_count_code{};
+std::array<CountStub::Counters, MAX_CLASSES * SLOTS> g_count_counters{};
+
+bool attach_count_stubs(const Config& config) {
+    if (g_count_code == nullptr) {
+        const auto size = CountStub::MAX_SIZE * MAX_CLASSES * SLOTS;
+        auto mem = mmap(nullptr, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (mem == MAP_FAILED) {
+            std::fprintf(stderr, "Failed to map count stubs\n");
+            return false;
+        }
+
+        g_count_code = (uint8_t*)mem;
+    }
+
+    for (size_t c = 0; c < config.classes; ++c) {
+        auto vtable = get_vtable(OBJECTS[c]);
+
+        for (size_t s = 0; s < SHARED_METHODS + config.methods; ++s) {
+            const auto k = c * SLOTS + s;
+            auto code = g_count_code + k * CountStub::MAX_SIZE;
+
+            g_count_counters[k].calls = 0;
+            g_count_counters[k].last_return_address = 0;
+            g_emulated[k].original = vtable[s];
+
+            if (CountStub::emit(code, &g_count_counters[k], &g_emulated[k].original) == 0) {
+                std::fprintf(stderr, "Failed to emit count stub %zu\n", k);
+                return false;
+            }
+
+            write_slot(&vtable[s], (uintptr_t)code);
+        }
+    }
+
+    return true;
+}
+
+// Sums the stub counters. Every stub that was called must also have seen a return address.
+uint64_t count_stub_calls(const Config& config, bool& return_addresses_ok) {
+    uint64_t result{};
+    return_addresses_ok = true;
+
+    for (size_t c = 0; c < config.classes; ++c) {
+        for (size_t s = 0; s < SHARED_METHODS + config.methods; ++s) {
+            const auto& counters = g_count_counters[c * SLOTS + s];
+            result += counters.calls;
+
+            if (counters.calls > 0 && counters.last_return_address == 0) {
+                return_addresses_ok = false;
+            }
+        }
+    }
+
+    return result;
+}
+
+uint64_t count_emulated(const Config& config) {
+    uint64_t result{};
+
+    for (size_t c = 0; c < config.classes; ++c) {
+        for (size_t s = 0; s < SHARED_METHODS + config.methods; ++s) {
+            result += g_emulated[c * SLOTS + s].calls;
+        }
+    }
+
+    return result;
+}
+
+size_t emulated_bytes_per_hook(const Config& config) {
+    size_t total{};
+    size_t hooks{};
+
+    for (size_t c = 0; c < config.classes; ++c) {
+        for (size_t s = 0; s < SHARED_METHODS + config.methods; ++s) {
+            total += sizeof(EmulatedHook) + g_emulated[c * SLOTS + s].callstack.capacity() * sizeof(uintptr_t);
+            ++hooks;
+        }
+    }
+
+    return hooks > 0 ? total / hooks : 0;
+}
+#endif
+
+BENCH_NOINLINE uint64_t call_at_depth(size_t depth, Base* obj, Method method, uint64_t x) {
+    if (depth == 0) {
+        return (obj->*method)(x);
+    }
+
+    // The + 1 keeps this from becoming a tail call, so each level is a real frame.
+    return call_at_depth(depth - 1, obj, method, x) + 1;
+}
+
+uint64_t run_thread(const Config& config, size_t thread_index) {
+    const auto slots = SHARED_METHODS + config.methods;
+    uint64_t state = 0x2545F4914F6CDD1Dull ^ thread_index;
+    uint64_t checksum{};
+
+    for (size_t i = 0; i < config.calls; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        const auto obj = OBJECTS[state % config.classes];
+        const auto method = METHODS[(state >> 8) % slots];
+        const auto depth = config.depth > 0 ? (state >> 16) % (config.depth + 1) : 0;
+
+        checksum += call_at_depth(depth, obj, method, state);
+    }
+
+    return checksum;
+}
+
+// Runs the workload on config.threads threads, returns the wall time and the combined checksum.
+std::pair<std::chrono::nanoseconds, uint64_t> run_workload(const Config& config) {
+    std::atomic<bool> go{};
+    std::atomic<size_t> ready{};
+    std::vector<uint64_t> checksums(config.threads);
+    std::vector<std::thread> threads{};
+
+    for (size_t t = 0; t < config.threads; ++t) {
+        threads.emplace_back([&, t]() {
+            ++ready;
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+
+            checksums[t] = run_thread(config, t);
+        });
+    }
+
+    while (ready.load() < config.threads) {
+        std::this_thread::yield();
+    }
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    go = true;
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    uint64_t checksum{};
+    for (const auto c : checksums) {
+        checksum += c;
+    }
+
+    return {end - start, checksum};
+}
+
+double to_ms(std::chrono::nanoseconds ns) {
+    return std::chrono::duration<double, std::milli>(ns).count();
+}
+
+Result run_mode(const Config& config, std::string_view mode, uint64_t expected_checksum) {
+    using clock = std::chrono::high_resolution_clock;
+
+    Result result{};
+    result.mode = mode;
+    result.implementation = "native";
+    result.threads = config.threads;
+
+    const auto total_calls = config.calls * config.threads;
+    std::chrono::nanoseconds attach{}, detach{}, elapsed{};
+
+    if (mode == "unhooked") {
+        std::tie(elapsed, result.checksum) = run_workload(config);
+        result.hooked_calls = total_calls;
+    } else if (mode == "count") {
+#ifdef _WIN32
+        result.implementation = "hooker";
+
+        auto start = clock::now();
+        auto hooks = create_hooks(config);
+
+        for (const auto& hook : hooks) {
+            hook->set_count_only(true);
+        }
+
+        attach = clock::now() - start;
+
+        std::tie(elapsed, result.checksum) = run_workload(config);
+
+        for (const auto& hook : hooks) {
+            result.hooked_calls += hook->get_calls();
+        }
+
+        result.hooks = hooks.size();
+        result.bytes_per_hook = sizeof(Hooker::Hook) + sizeof(CountStub::Counters) + CountStub::MAX_SIZE + Hooker::STUB_SIZE;
+
+        start = clock::now();
+        destroy_hooks(hooks);
+        detach = clock::now() - start;
+#else
+        result.implementation = "count_stub";
+
+        auto start = clock::now();
+        if (!attach_count_stubs(config)) {
+            return result;
+        }
+        attach = clock::now() - start;
+
+        bool return_addresses_ok{};
+        std::tie(elapsed, result.checksum) = run_workload(config);
+        result.hooked_calls = count_stub_calls(config, return_addresses_ok);
+        result.hooks = config.classes * (SHARED_METHODS + config.methods);
+        result.bytes_per_hook = sizeof(CountStub::Counters) + CountStub::MAX_SIZE;
+
+        if (!return_addresses_ok) {
+            result.hooked_calls = 0; // Fails verification.
+        }
+
+        start = clock::now();
+        detach_emulated(config);
+        detach = clock::now() - start;
+#endif
+    } else if (mode == "capture") {
+#ifdef _WIN32
+        result.implementation = "hooker";
+
+        auto start = clock::now();
+        auto hooks = create_hooks(config);
+
+        for (const auto& hook : hooks) {
+            if (auto err = hook->impl.enable(); !err.has_value()) {
+                std::fprintf(stderr, "Failed to enable hook on 0x%llx\n", (unsigned long long)hook->target);
+            }
+        }
+
+        attach = clock::now() - start;
+
+        std::tie(elapsed, result.checksum) = run_workload(config);
+
+        size_t total_bytes{};
+        for (const auto& hook : hooks) {
+            result.hooked_calls += hook->calls;
+            total_bytes += sizeof(Hooker::Hook) + hook->get_callstack().capacity() * sizeof(uintptr_t) + Hooker::STUB_SIZE;
+        }
+
+        result.hooks = hooks.size();
+        result.bytes_per_hook = result.hooks > 0 ? total_bytes / result.hooks : 0;
+
+        start = clock::now();
+        destroy_hooks(hooks);
+        detach = clock::now() - start;
+#else
+        result.implementation = "emulated";
+
+        auto start = clock::now();
+        attach_emulated(config, CAPTURE_THUNKS);
+        attach = clock::now() - start;
+
+        std::tie(elapsed, result.checksum) = run_workload(config);
+        result.hooked_calls = count_emulated(config);
+        result.hooks = config.classes * (SHARED_METHODS + config.methods);
+        result.bytes_per_hook = emulated_bytes_per_hook(config);
+
+        start = clock::now();
+        detach_emulated(config);
+        detach = clock::now() - start;
+#endif
+    } else {
+        std::fprintf(stderr, "Unknown mode: %.*s\n", (int)mode.size(), mode.data());
+        return result;
+    }
+
+    const auto ns = (double)elapsed.count();
+    result.ns_per_call = total_calls > 0 ? ns * config.threads / total_calls : 0.0;
+    result.calls_per_second = ns > 0 ? total_calls / (ns / 1e9) : 0.0;
+    result.attach_ms = to_ms(attach);
+    result.detach_ms = to_ms(detach);
+    result.verified = result.checksum == expected_checksum && result.hooked_calls == total_calls;
+
+    return result;
+}
+
+RateResult run_rate_tracker(size_t hooks, size_t top_k) {
+    using clock = std::chrono::high_resolution_clock;
+
+    RateResult result{};
+    result.hooks = hooks;
+    result.top_k = top_k;
+    result.ticks = RateTracker::SECONDS * RateTracker::MINUTES; // Enough to hit every downsampling step.
+
+    std::vector<uint64_t> counters(hooks);
+    RateTracker tracker{hooks, [&](std::span<uint64_t> counts) {
+        std::copy(counters.begin(), counters.end(), counts.begin());
+    }, top_k, false};
+
+    // Most hooks idle, a few hot ones that move around between ticks.
+    const auto calls_for = [](size_t id, size_t tick) -> uint64_t {
+        const auto h = (id * 2654435761u) ^ (tick * 40503u);
+        return h % 7 == 0 ? h % 10000 : 0;
+    };
+
+    std::chrono::nanoseconds elapsed{};
+
+    for (size_t tick = 0; tick < result.ticks; ++tick) {
+        for (size_t id = 0; id < hooks; ++id) {
+            counters[id] += calls_for(id, tick);
+        }
+
+        const auto start = clock::now();
+        tracker.tick(1.0f);
+        elapsed += clock::now() - start;
+    }
+
+    result.us_per_tick = (double)elapsed.count() / 1000.0 / result.ticks;
+    result.ns_per_hook = hooks > 0 ? (double)elapsed.count() / result.ticks / hooks : 0.0;
+    result.bytes_per_hook = hooks > 0 ? tracker.get_memory_usage() / hooks : 0;
+
+    // The published top K has to match a full sort of the last tick.
+    std::vector<RateTracker::Entry> expected{};
+
+    for (size_t id = 0; id < hooks; ++id) {
+        if (const auto calls = calls_for(id, result.ticks - 1); calls > 0) {
+            expected.push_back({(uint32_t)id, (float)calls});
+        }
+    }
+
+    std::sort(expected.begin(), expected.end(), [](const auto& a, const auto& b) {
+        return a.rate > b.rate || (a.rate == b.rate && a.id < b.id);
+    });
+
+    expected.resize(std::min(expected.size(), top_k));
+
+    const auto top = tracker.get_top();
+    result.verified = top->size() == expected.size() && std::equal(top->begin(), top->end(), expected.begin(), [](const auto& a, const auto& b) {
+        return a.id == b.id && a.rate == b.rate;
+    });
+
+    // And the rings have to hold the last sample.
+    for (size_t id = 0; id < hooks && result.verified; ++id) {
+        result.verified = tracker.get_rate((uint32_t)id) == (float)calls_for(id, result.ticks - 1);
+    }
+
+    // Same size again, but shaped like a survey, where only a few hooks are ever called.
+    std::fill(counters.begin(), counters.end(), 0);
+    RateTracker survey{hooks, [&](std::span<uint64_t> counts) {
+        std::copy(counters.begin(), counters.end(), counts.begin());
+    }, top_k, false};
+
+    for (size_t tick = 0; tick < RateTracker::SECONDS; ++tick) {
+        for (size_t id = 0; id < hooks; id += 100 / SURVEY_HOT_PERCENT) {
+            counters[id] += tick + 1;
+        }
+
+        survey.tick(1.0f);
+    }
+
+    result.survey_bytes_per_hook = hooks > 0 ? survey.get_memory_usage() / hooks : 0;
+    result.verified = result.verified &&
+        survey.get_tracked_count() == (hooks + 100 / SURVEY_HOT_PERCENT - 1) / (100 / SURVEY_HOT_PERCENT) &&
+        result.survey_bytes_per_hook <= SURVEY_RATE_BUDGET;
+
+    return result;
+}
+
+std::vector<std::string> split(std::string_view str, char delim) {
+    std::vector<std::string> result{};
+
+    while (!str.empty()) {
+        const auto pos = str.find(delim);
+        result.emplace_back(str.substr(0, pos));
+
+        if (pos == std::string_view::npos) {
+            break;
+        }
+
+        str.remove_prefix(pos + 1);
+    }
+
+    return result;
+}
+
+bool parse_args(int argc, char** argv, Config& config) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg{argv[i]};
+
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "Missing value for %s\n", argv[i]);
+            return false;
+        }
+
+        const char* value = argv[++i];
+
+        if (arg == "--classes") {
+            config.classes = std::clamp<size_t>(std::strtoull(value, nullptr, 10), 1, MAX_CLASSES);
+        } else if (arg == "--methods") {
+            config.methods = std::clamp<size_t>(std::strtoull(value, nullptr, 10), 1, MAX_METHODS);
+        } else if (arg == "--threads") {
+            config.thread_counts.clear();
+
+            for (const auto& threads : split(value, ',')) {
+                if (const auto n = std::strtoull(threads.c_str(), nullptr, 10); n > 0) {
+                    config.thread_counts.push_back(n);
+                }
+            }
+
+            if (config.thread_counts.empty()) {
+                config.thread_counts.push_back(1);
+            }
+        } else if (arg == "--depth") {
+            config.depth = std::strtoull(value, nullptr, 10);
+        } else if (arg == "--calls") {
+            config.calls = std::strtoull(value, nullptr, 10);
+        } else if (arg == "--modes") {
+            config.modes = split(value, ',');
+        } else if (arg == "--out") {
+            config.out = value;
+        } else if (arg == "--rate-hooks") {
+            config.rate_hooks.clear();
+
+            for (const auto& hooks : split(value, ',')) {
+                if (const auto n = std::strtoull(hooks.c_str(), nullptr, 10); n > 0) {
+                    config.rate_hooks.push_back(n);
+                }
+            }
+        } else if (arg == "--top-k") {
+            config.top_k = std::strtoull(value, nullptr, 10);
+        } else {
+            std::fprintf(stderr, "Unknown argument: %s\n", argv[i - 1]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::string to_json(const Config& config, const std::vector<Result>& results, const std::vector<RateResult>& rate_results) {
+    std::string json{};
+    char buf[512]{};
+
+#ifdef _WIN32
+    constexpr const char* platform = "windows";
+#else
+    constexpr const char* platform = "linux";
+#endif
+
+    std::string thread_counts{};
+
+    for (const auto threads : config.thread_counts) {
+        thread_counts += (thread_counts.empty() ? "" : ", ") + std::to_string(threads);
+    }
+
+    std::snprintf(buf, sizeof(buf),
+        "{\n  \"platform\": \"%s\",\n  \"config\": {\"classes\": %zu, \"methods\": %zu, \"shared_methods\": %zu, "
+        "\"threads\": [%s], \"depth\": %zu, \"calls_per_thread\": %zu},\n  \"results\": [\n",
+        platform, config.classes, config.methods, SHARED_METHODS, thread_counts.c_str(), config.depth, config.calls);
+    json += buf;
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+
+        std::snprintf(buf, sizeof(buf),
+            "    {\"mode\": \"%s\", \"implementation\": \"%s\", \"threads\": %zu, \"ns_per_call\": %.3f, \"calls_per_second\": %.0f, "
+            "\"attach_ms\": %.3f, \"detach_ms\": %.3f, \"hooks\": %zu, \"bytes_per_hook\": %zu, "
+            "\"hooked_calls\": %llu, \"checksum\": %llu, \"verified\": %s}%s\n",
+            r.mode.c_str(), r.implementation.c_str(), r.threads, r.ns_per_call, r.calls_per_second,
+            r.attach_ms, r.detach_ms, r.hooks, r.bytes_per_hook,
+            (unsigned long long)r.hooked_calls, (unsigned long long)r.checksum, r.verified ? "true" : "false",
+            i + 1 < results.size() ? "," : "");
+        json += buf;
+    }
+
+    json += "  ],\n  \"rate_tracker\": [\n";
+
+    for (size_t i = 0; i < rate_results.size(); ++i) {
+        const auto& r = rate_results[i];
+
+        std::snprintf(buf, sizeof(buf),
+            "    {\"hooks\": %zu, \"top_k\": %zu, \"ticks\": %zu, \"us_per_tick\": %.3f, \"ns_per_hook\": %.3f, "
+            "\"bytes_per_hook\": %zu, \"survey_bytes_per_hook\": %zu, \"verified\": %s}%s\n",
+            r.hooks, r.top_k, r.ticks, r.us_per_tick, r.ns_per_hook, r.bytes_per_hook, r.survey_bytes_per_hook, r.verified ? "true" : "false",
+            i + 1 < rate_results.size() ? "," : "");
+        json += buf;
+    }
+
+    json += "  ]\n}\n";
+    return json;
+}
+}
+
+int main(int argc, char** argv) {
+    using namespace bench;
+
+    Config config{};
+    if (!parse_args(argc, argv, config)) {
+        return 1;
+    }
+
+#ifdef _WIN32
+    spdlog::set_level(spdlog::level::warn);
+#endif
+
+    std::vector<Result> results{};
+
+    for (const auto threads : config.thread_counts) {
+        Config run_config = config;
+        run_config.threads = threads;
+
+        // The unhooked run is always done first, it provides the reference checksum.
+        const auto baseline = run_mode(run_config, "unhooked", 0);
+
+        for (const auto& mode : config.modes) {
+            if (mode == "unhooked") {
+                auto result = baseline;
+                result.verified = true;
+                results.push_back(result);
+                continue;
+            }
+
+            results.push_back(run_mode(run_config, mode, baseline.checksum));
+        }
+    }
+
+    std::vector<RateResult> rate_results{};
+
+    for (const auto hooks : config.rate_hooks) {
+        rate_results.push_back(run_rate_tracker(hooks, config.top_k));
+    }
+
+    const auto json = to_json(config, results, rate_results);
+
+    if (config.out.empty()) {
+        std::fputs(json.c_str(), stdout);
+    } else if (auto f = std::fopen(config.out.c_str(), "w"); f != nullptr) {
+        std::fputs(json.c_str(), f);
+        std::fclose(f);
+    } else {
+        std::fprintf(stderr, "Failed to open %s\n", config.out.c_str());
+        return 1;
+    }
+
+    const auto verified = std::all_of(results.begin(), results.end(), [](const Result& r) { return r.verified; }) &&
+        std::all_of(rate_results.begin(), rate_results.end(), [](const RateResult& r) { return r.verified; });
+
+    return verified ? 0 : 2;
+}
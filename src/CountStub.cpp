@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <optional>
+
+#include "CountStub.hpp"
+
+namespace {
+// Displacement from the end of an instruction to target, if it fits in a rel32.
+std::optional<int32_t> rel32(const uint8_t* instruction_end, const void* target) {
+    const auto disp = (intptr_t)target - (intptr_t)instruction_end;
+
+    if (disp < std::numeric_limits<int32_t>::min() || disp > std::numeric_limits<int32_t>::max()) {
+        return std::nullopt;
+    }
+
+    return (int32_t)disp;
+}
+
+// Worst case distance from any instruction in the stub, checked from the start of the code.
+bool in_reach(const uint8_t* code, const void* target) {
+    return rel32(code, target).has_value() && rel32(code + CountStub::MAX_SIZE, target).has_value();
+}
+}
+
+size_t CountStub::emit(uint8_t* code, std::atomic<uint64_t>* calls, std::atomic<uintptr_t>* last_return_address, const uintptr_t* original) {
+    uint8_t* p = code;
+
+    auto emit_bytes = [&](std::initializer_list<uint8_t> bytes) {
+        std::copy(bytes.begin(), bytes.end(), p);
+        p += bytes.size();
+    };
+
+    auto emit_value = [&](auto value) {
+        std::memcpy(p, &value, sizeof(value));
+        p += sizeof(value);
+    };
+
+    // Opcode followed by a rel32 to target. Only called once in_reach has been checked.
+    auto emit_rip_relative = [&](std::initializer_list<uint8_t> opcode, const void* target) {
+        emit_bytes(opcode);
+        emit_value(*rel32(p + sizeof(int32_t), target));
+    };
+
+    const auto counters_in_reach = in_reach(code, calls) && (last_return_address == nullptr || in_reach(code, last_return_address));
+
+    if (counters_in_reach && in_reach(code, original)) {
+        emit_rip_relative({0xF0, 0x48, 0xFF, 0x05}, calls); // lock inc qword ptr [rip + calls]
+
+        if (last_return_address != nullptr) {
+            emit_bytes({0x4C, 0x8B, 0x1C, 0x24}); // mov r11, qword ptr [rsp]
+            emit_rip_relative({0x4C, 0x89, 0x1D}, last_return_address); // mov qword ptr [rip + last_return_address], r11
+        }
+
+        emit_rip_relative({0xFF, 0x25}, original); // jmp qword ptr [rip + original]
+        return (size_t)(p - code);
+    }
+
+    const auto return_address_disp = last_return_address != nullptr ? rel32((const uint8_t*)calls, last_return_address) : 0;
+    if (!return_address_disp.has_value()) {
+        return 0;
+    }
+
+    emit_bytes({0x49, 0xBB}); // mov r11, &calls
+    emit_value((uintptr_t)calls);
+    emit_bytes({0xF0, 0x49, 0xFF, 0x03}); // lock inc qword ptr [r11]
+
+    if (last_return_address != nullptr) {
+        emit_bytes({0x4C, 0x8B, 0x14, 0x24}); // mov r10, qword ptr [rsp]
+        emit_bytes({0x4D, 0x89, 0x93}); // mov qword ptr [r11 + disp32], r10
+        emit_value(*return_address_disp);
+    }
+
+    emit_bytes({0xFF, 0x25, 0x00, 0x00, 0x00, 0x00}); // jmp qword ptr [rip + 0]
+    emit_value(*original);
+
+    return (size_t)(p - code);
+}
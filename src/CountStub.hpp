@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Count-only hook stub. Bumps a counter, optionally records the return address and jumps
+// straight to the original through the trampoline. No context spill, no C++ call.
+//
+// When the counters and the jump target are within +-2GB of the code:
+//  lock inc qword ptr [rip + calls]
+//  mov r11, qword ptr [rsp]                        ; only when recording the return address
+//  mov qword ptr [rip + last_return_address], r11
+//  jmp qword ptr [rip + original]
+//
+// Otherwise:
+//  mov r11, &calls
+//  lock inc qword ptr [r11]
+//  mov r10, qword ptr [rsp]                        ; only when recording the return address
+//  mov qword ptr [r11 + (last_return_address - calls)], r10
+//  jmp qword ptr [rip + 0]
+//  dq original
+//
+// r10 and r11 are volatile and never carry arguments into a member function in either
+// the Windows or the SysV x64 ABI.
+struct CountStub {
+    // Must not live on the same page as the code, or anything else being executed.
+    // Stores to a page the CPU is executing from are treated as self-modifying code and
+    // cost a machine clear on every call, more than everything else in the stub combined.
+    struct alignas(64) Counters {
+        std::atomic<uint64_t> calls{};
+        std::atomic<uintptr_t> last_return_address{};
+    };
+
+    static constexpr size_t MAX_SIZE{40};
+
+    // Writes the stub to `code`, which is also where it will execute from. last_return_address can be null.
+    // If `original` is out of reach of the code, its current value is baked into the stub instead.
+    // Returns the size of the code, or 0 if last_return_address is more than +-2GB away from calls.
+    static size_t emit(uint8_t* code, std::atomic<uint64_t>* calls, std::atomic<uintptr_t>* last_return_address, const uintptr_t* original);
+
+    // Always records the return address, the GUI shows it for count-only hooks too.
+    static size_t emit(uint8_t* code, Counters* counters, const uintptr_t* original) {
+        return emit(code, &counters->calls, &counters->last_return_address, original);
+    }
+};
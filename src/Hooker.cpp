@@ -13,14 +13,8 @@ Hooker::Hooker(uintptr_t* vtable)
     for_each(vtable, [this](uintptr_t entry, size_t i) {
         spdlog::info("Hooking {} at 0x{:x}", i, entry);
 
-        auto& hook = m_hooks.emplace_back(std::make_shared<Hook>());
+        auto& hook = m_hooks.emplace_back(create_hook(this, entry, i));
         m_hook_map[i] = hook;
-
-        hook->parent = this;
-        hook->target = entry;
-        hook->stub_code = create_stub(i, hook.get());
-        hook->index = i;
-        hook->impl = safetyhook::create_mid(entry, (safetyhook::MidHookFn)hook->stub_code.get(), safetyhook::MidHook::Flags::StartDisabled);
     });
 
     // Enable all the hooks now, is more thread safe.
@@ -30,13 +24,73 @@ Hooker::Hooker(uintptr_t* vtable)
         }
     }
 
+    if (!m_hooks.empty()) {
+        m_rates = std::make_unique<RateTracker>(m_hooks.size(), [this](std::span<uint64_t> counts) {
+            for (size_t i = 0; i < m_hooks.size(); ++i) {
+                counts[i] = m_hooks[i]->get_calls();
+            }
+        });
+    }
+
     spdlog::info("Done hooking vtable at 0x{:x}", (uintptr_t)vtable);
 }
 
+std::shared_ptr<Hooker::Hook> Hooker::create_hook(Hooker* parent, uintptr_t target, size_t index) {
+    auto hook = std::make_shared<Hook>();
+
+    hook->parent = parent;
+    hook->target = target;
+    hook->stub_code = create_stub((uint32_t)index, hook.get());
+    hook->index = index;
+    hook->impl = safetyhook::create_mid(target, (safetyhook::MidHookFn)hook->stub_code.get(), safetyhook::MidHook::Flags::StartDisabled);
+
+    return hook;
+}
+
+void Hooker::Hook::set_count_only(bool value) {
+    if (count_only == value) {
+        return;
+    }
+
+    const auto disabled = value ? impl.disable().has_value() : count_impl.disable().has_value();
+    if (!disabled) {
+        spdlog::error("Failed to disable hook for index: {}", index);
+        return;
+    }
+
+    // Only made once it's needed, most hooks never go count-only.
+    // The full hook is disabled at this point, so this hooks the original bytes rather than the MidHook's jump.
+    if (value && !count_impl && !create_count_stub(*this)) {
+        spdlog::error("Failed to create count-only hook for index: {}", index);
+
+        if (!impl.enable().has_value()) {
+            spdlog::error("Failed to re-enable hook for index: {}", index);
+        }
+
+        return;
+    }
+
+    const auto enabled = value ? count_impl.enable().has_value() : impl.enable().has_value();
+    if (!enabled) {
+        spdlog::error("Failed to enable {} hook for index: {}", value ? "count-only" : "full", index);
+
+        // Put the one we just disabled back, count_only still describes it.
+        const auto restored = value ? impl.enable().has_value() : count_impl.enable().has_value();
+        if (!restored) {
+            spdlog::error("Failed to re-enable hook for index: {}", index);
+        }
+
+        return;
+    }
+
+    count_only = value;
+}
+
 void Hooker::generic_hook(safetyhook::Context& ctx, Hook* hook) {
     auto hooker = hook->parent;
     // This is a function belonging to another vtable, ignore it.
-    if (!s_ignore_vtable_mismatch && *(uintptr_t*)ctx.rcx != hooker->get_target()) {
+    // Hooks without a parent (e.g. from a Survey) belong to a function, not a vtable.
+    if (!s_ignore_vtable_mismatch && hooker != nullptr && *(uintptr_t*)ctx.rcx != hooker->get_target()) {
         return;
     }
 
@@ -173,7 +227,7 @@ size_t Hooker::count(uintptr_t* vtable) {
 }
 
 std::unique_ptr<uint8_t[]> Hooker::create_stub(uint32_t vtable_index, void* hook_data) {
-    std::vector<uint8_t> initial_data {
+    std::array<uint8_t, STUB_SIZE> initial_data {
         0x48, 0x8B, 0x15, 0x0E, 0x00, 0x00, 0x00, // mov rdx, [rip + 14]
         0xFF, 0x25, 0x00, 0x00, 0x00, 0x00, // jmp [rip + 0]
         0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // ptr to generic_hook
@@ -192,4 +246,33 @@ std::unique_ptr<uint8_t[]> Hooker::create_stub(uint32_t vtable_index, void* hook
     std::copy(initial_data.begin(), initial_data.end(), new_data.get());
 
     return new_data;
+}
+
+// Created disabled while the full hook is disabled, so both hook the same original bytes and set_count_only can flip between them.
+bool Hooker::create_count_stub(Hook& hook) {
+    // The code comes from safetyhook's allocator so it sits with the trampolines, away from
+    // the counters, which get written on every call.
+    auto code = safetyhook::Allocator::global()->allocate(CountStub::MAX_SIZE);
+    if (!code.has_value()) {
+        return false;
+    }
+
+    hook.count_counters = std::make_unique<CountStub::Counters>();
+    hook.count_code = std::move(*code);
+    hook.count_impl = safetyhook::create_inline(hook.target, hook.count_code.address(), safetyhook::InlineHook::Flags::StartDisabled);
+
+    if (!hook.count_impl) {
+        return false;
+    }
+
+    // The stub may reference this by address, so it has to live as long as the hook.
+    hook.count_original = (uintptr_t)hook.count_impl.original<void*>();
+
+    if (CountStub::emit(hook.count_code.data(), hook.count_counters.get(), &hook.count_original) == 0) {
+        hook.count_impl = {};
+        return false;
+    }
+
+    hook.count_ready = true;
+    return true;
 }
\ No newline at end of file
@@ -13,6 +13,9 @@
 #include <utility/Thread.hpp>
 #include <utility/Scan.hpp>
 
+#include "CountStub.hpp"
+#include "RateTracker.hpp"
+
 class Hooker { // haw haw real funny
 public:
     static inline bool s_ignore_vtable_mismatch{};
@@ -25,6 +28,12 @@ public:
         uintptr_t target{};
         safetyhook::MidHook impl{};
         std::unique_ptr<uint8_t[]> stub_code{};
+        std::unique_ptr<CountStub::Counters> count_counters{};
+        safetyhook::Allocation count_code{};
+        safetyhook::InlineHook count_impl{}; // Shares the target with impl, only one of them is ever enabled.
+        uintptr_t count_original{}; // count_impl's trampoline, the count stub jumps through this.
+        std::atomic<bool> count_ready{}; // Set once the count-only members above exist, they're read from other threads.
+        std::atomic<bool> count_only{};
         size_t index{};
         std::atomic<size_t> calls{};
         std::atomic<uintptr_t> last_return_address{};
@@ -37,12 +46,35 @@ public:
         } sensitive_data{};
         std::optional<uint8_t> original_byte{};
 
+        // Calls seen by both the full hook and the count-only stub.
+        size_t get_calls() const {
+            return calls.load() + (count_ready ? count_counters->calls.load() : 0);
+        }
+
+        uintptr_t get_last_return_address() const {
+            if (count_only && count_ready) {
+                return count_counters->last_return_address.load();
+            }
+
+            return last_return_address.load();
+        }
+
+        // Switches between the full capture hook and the count-only stub, creating the stub the first time.
+        // The count-only stub doesn't check for vtable mismatches, it counts every call to the function.
+        void set_count_only(bool value);
+
         // Returns a copy of the callstack.
         std::vector<uintptr_t> get_callstack() {
             std::shared_lock _{sensitive_data.mutex};
             return sensitive_data.callstack;
         }
 
+        // Capacity of the callstack in entries, without copying it.
+        size_t get_callstack_capacity() {
+            std::shared_lock _{sensitive_data.mutex};
+            return sensitive_data.callstack.capacity();
+        }
+
         // Returns a copy of the last context.
         safetyhook::Context get_last_context() {
             std::shared_lock _{sensitive_data.mutex};
@@ -100,7 +132,21 @@ public:
         return nullptr;
     }
 
+    // The hook on the function at target, if this vtable points to it.
+    std::shared_ptr<Hook> find_hook_by_target(uintptr_t target) const {
+        for (const auto& hook : m_hooks) {
+            if (hook->target == target) {
+                return hook;
+            }
+        }
+
+        return nullptr;
+    }
+
 public:
+    // Creates a disabled hook on target. parent can be null, then it doesn't filter by vtable.
+    static std::shared_ptr<Hook> create_hook(Hooker* parent, uintptr_t target, size_t index);
+
     using ForEachFn = std::function<void(uintptr_t fn, size_t index)>;
     static void for_each(uintptr_t* vtable, ForEachFn fn);
     static size_t count(uintptr_t* vtable);
@@ -110,6 +156,8 @@ public:
     virtual ~Hooker() {
         spdlog::info("Unhooking vtable at 0x{:x}", (uintptr_t)m_target);
 
+        m_rates.reset(); // Reads the hooks.
+
         for (const auto& hook : m_hooks) {
             hook->restore();
         }
@@ -123,14 +171,24 @@ public:
         return (uintptr_t)m_target;
     }
 
+    // Indexed by position in get_hooks(). Null if there are no hooks.
+    RateTracker* get_rates() const {
+        return m_rates.get();
+    }
+
+    // Size of the code generated by create_stub.
+    static constexpr size_t STUB_SIZE{29};
+
 private:
     static std::unique_ptr<uint8_t[]> create_stub(uint32_t vtable_index, void* hook_data);
+    static bool create_count_stub(Hook& hook);
 
     uintptr_t* m_target{};
     std::type_info* m_type_info{};
 
     std::vector<std::shared_ptr<Hook>> m_hooks{};
     std::unordered_map<size_t, std::shared_ptr<Hook>> m_hook_map{};
+    std::unique_ptr<RateTracker> m_rates{};
 
     safetyhook::InlineHook m_special_hook{};
 };
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <array>
 #include <deque>
+#include <filesystem>
 
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/base_sink.h>
@@ -24,6 +25,10 @@
 #include <imgui_impl_opengl3.h>
 
 #include "Hooker.hpp"
+#include "RateTracker.hpp"
+#include "ScanCache.hpp"
+#include "Survey.hpp"
+#include "SymbolResolver.hpp"
 
 HMODULE g_hModule = nullptr;
 
@@ -85,6 +90,53 @@ private:
 
 std::string selected_module_name{};
 HMODULE selected_module{}; // The selected module
+RateTracker::Resolution rate_resolution{}; // What the sparklines show
+
+// Sparkline of one series, labelled with its last per-second rate.
+void render_rate(const RateTracker* rates, uint32_t id) {
+    if (rates == nullptr) {
+        return;
+    }
+
+    const auto series = rates->get_series(id, rate_resolution);
+    const auto overlay = std::format("{:.1f}/s", rates->get_rate(id));
+
+    ImGui::PlotLines("##rate", series.values.data(), series.size, series.offset, overlay.c_str(), 0.0f, FLT_MAX, ImVec2(0, 30));
+}
+
+void render_rate_resolution() {
+    constexpr const char* names[]{"Last Minute", "Last Hour", "Last Day"};
+
+    auto current = (int)rate_resolution;
+    ImGui::SetNextItemWidth(150);
+
+    if (ImGui::Combo("Rate Window", &current, names, IM_ARRAYSIZE(names))) {
+        rate_resolution = (RateTracker::Resolution)current;
+    }
+}
+
+// The tracker's current top K, nothing gets sorted here.
+template<typename NameFn>
+void render_hottest(const RateTracker* rates, NameFn&& name) {
+    if (rates == nullptr) {
+        return;
+    }
+
+    const auto top = rates->get_top();
+
+    if (!ImGui::CollapsingHeader(std::format("Hottest ({})###Hottest", top->size()).c_str())) {
+        return;
+    }
+
+    for (const auto& entry : *top) {
+        ImGui::PushID((int)entry.id);
+        ImGui::Text("%10.1f/s  %s", entry.rate, name(entry.id).c_str());
+        ImGui::SameLine(ImGui::GetWindowWidth() * 0.6f);
+        ImGui::SetNextItemWidth(-1);
+        render_rate(rates, entry.id);
+        ImGui::PopID();
+    }
+}
 
 void copy_to_clipboard(std::string_view text) {
     if (OpenClipboard(nullptr)) {
@@ -99,8 +151,291 @@ void copy_to_clipboard(std::string_view text) {
     }
 }
 
+// The selected module's scan cache, see ScanCache.hpp.
+struct ModuleScan {
+    enum class Validation : uint8_t {
+        UNCHECKED,
+        VALID,
+        STALE,
+    };
+
+    HMODULE module{};
+    ScanCache::ModuleIdentity identity{};
+    std::optional<ScanCache> cache{};
+    std::vector<Validation> validation{}; // Per cached vtable, checked the first time it's actually used.
+} g_module_scan{};
+
+std::unordered_map<uintptr_t, size_t> g_vtable_counts{};
+std::unordered_map<uintptr_t, std::vector<uintptr_t>> g_vtable_references{};
+
+ScanCache::ModuleIdentity get_module_identity(HMODULE module) {
+    const auto dos = (IMAGE_DOS_HEADER*)module;
+    const auto nt = (IMAGE_NT_HEADERS*)((uintptr_t)module + dos->e_lfanew);
+
+    return {nt->OptionalHeader.SizeOfImage, nt->FileHeader.TimeDateStamp};
+}
+
+// <our dll's directory>/vtable-monitor-cache/<module name>.vtmc
+std::filesystem::path get_scan_cache_path(HMODULE module) {
+    const auto own_path = utility::get_module_path(g_hModule);
+    const auto module_path = utility::get_module_path(module);
+
+    const auto dir = own_path.has_value() ? std::filesystem::path{*own_path}.parent_path() : std::filesystem::current_path();
+    const auto name = module_path.has_value() ? std::filesystem::path{*module_path}.filename().string() : std::format("{:x}", (uintptr_t)module);
+
+    return dir / "vtable-monitor-cache" / (name + ".vtmc");
+}
+
+// Checks a cached vtable against the live module before it gets dereferenced.
+bool validate_cached_vtable(size_t i) {
+    auto& validation = g_module_scan.validation[i];
+
+    if (validation == ModuleScan::Validation::UNCHECKED) {
+        const auto vtable = (uintptr_t)g_module_scan.module + g_module_scan.cache->get_vtables()[i].rva;
+        validation = utility::rtti::is_vtable((const void*)vtable) ? ModuleScan::Validation::VALID : ModuleScan::Validation::STALE;
+
+        if (validation == ModuleScan::Validation::STALE) {
+            spdlog::warn("Cached vtable at 0x{:x} is stale, it will be dropped on the next save", vtable);
+        }
+    }
+
+    return validation == ModuleScan::Validation::VALID;
+}
+
+// While a survey is running the vtable slots in its module point at survey stubs, so a Hooker
+// would hook those instead of the real functions, and be left patching freed memory once the survey stops.
+// A survey capture is a MidHook too, and the two can't be stacked on the same function, see Survey::capture.
+bool can_hook_vtable(uintptr_t vtable) {
+    if (g_survey == nullptr) {
+        return true;
+    }
+
+    if (utility::get_module_within(vtable).value_or(nullptr) == g_survey->get_module()) {
+        spdlog::warn("Can't hook vtable at 0x{:x} while its module is being surveyed, stop the survey first", vtable);
+        return false;
+    }
+
+    auto captured = false;
+
+    Hooker::for_each((uintptr_t*)vtable, [&](uintptr_t fn, size_t index) {
+        captured = captured || g_survey->is_captured(fn);
+    });
+
+    if (captured) {
+        spdlog::warn("Can't hook vtable at 0x{:x}, some of its functions have survey captures, stop the survey first", vtable);
+        return false;
+    }
+
+    return true;
+}
+
+// The other way around: the survey would patch the slots the Hooker's vtable is in, and its captures
+// would land on top of the Hooker's hooks.
+bool can_survey_module(HMODULE module) {
+    if (g_hooker != nullptr && utility::get_module_within(g_hooker->get_target()).value_or(nullptr) == module) {
+        spdlog::warn("Can't survey module at 0x{:x} while one of its vtables is hooked, unhook it first", (uintptr_t)module);
+        return false;
+    }
+
+    return true;
+}
+
+void reattach_cached_hooks() {
+    const auto hooks = g_module_scan.cache->get_hooks();
+
+    if (hooks.empty() || g_hooker != nullptr) {
+        return;
+    }
+
+    // Only one vtable can be hooked at a time.
+    const auto vtable_rva = hooks[0].vtable_rva;
+    const auto vtable = (uintptr_t)g_module_scan.module + vtable_rva;
+
+    if (!utility::rtti::is_vtable((const void*)vtable)) {
+        spdlog::warn("Saved hooks point to 0x{:x}, which is no longer a vtable", vtable);
+        return;
+    }
+
+    if (!can_hook_vtable(vtable)) {
+        return;
+    }
+
+    spdlog::info("Re-attaching {} saved hooks", hooks.size());
+    g_hooker = std::make_unique<Hooker>((uintptr_t*)vtable);
+
+    for (const auto& saved : hooks) {
+        if (saved.vtable_rva != vtable_rva || (saved.flags & ScanCache::COUNT_ONLY) == 0) {
+            continue;
+        }
+
+        if (auto hook = g_hooker->find_hook(saved.index); hook != nullptr) {
+            hook->set_count_only(true);
+        }
+    }
+}
+
+// Maps the selected module's cache file, if there's a usable one.
+bool open_scan_cache() {
+    g_module_scan = {};
+    g_module_scan.module = selected_module;
+
+    if (selected_module == nullptr) {
+        return false;
+    }
+
+    g_module_scan.identity = get_module_identity(selected_module);
+    g_module_scan.cache = ScanCache::open(get_scan_cache_path(selected_module), g_module_scan.identity);
+
+    if (!g_module_scan.cache.has_value()) {
+        return false;
+    }
+
+    g_module_scan.validation.resize(g_module_scan.cache->get_vtables().size());
+    return true;
+}
+
+// Writes the selected module's scan cache, along with the current hooks.
+// Without rescan the existing cache is reused, plus whatever references were scanned since.
+void write_scan_cache(bool rescan) {
+    const auto module = selected_module;
+    const auto base = (uintptr_t)module;
+
+    ScanCache::Builder builder{};
+
+    auto add_vtable = [&](uintptr_t vtable, size_t count, std::string_view name, std::optional<std::span<const uint32_t>> references) {
+        std::vector<uint32_t> reference_rvas{};
+
+        if (auto it = g_vtable_references.find(vtable); it != g_vtable_references.end()) {
+            for (const auto ref : it->second) {
+                reference_rvas.push_back((uint32_t)(ref - base));
+            }
+
+            references = reference_rvas;
+        }
+
+        builder.add_vtable((uint32_t)(vtable - base), (uint32_t)count, name, references);
+    };
+
+    if (rescan || !g_module_scan.cache.has_value()) {
+        for (const auto vtable : utility::rtti::find_all_vtables(module)) {
+            const auto ti = utility::rtti::get_type_info(&vtable);
+            const auto name = (ti != nullptr && ti->name() != nullptr) ? ti->name() : "";
+
+            add_vtable(vtable, Hooker::count((uintptr_t*)vtable), name, std::nullopt);
+        }
+    } else {
+        const auto& cache = *g_module_scan.cache;
+        const auto vtables = cache.get_vtables();
+
+        for (size_t i = 0; i < vtables.size(); ++i) {
+            if (g_module_scan.validation[i] != ModuleScan::Validation::STALE) {
+                add_vtable(base + vtables[i].rva, vtables[i].count, cache.get_name(vtables[i]), cache.get_references(vtables[i]));
+            }
+        }
+    }
+
+    if (g_hooker != nullptr && utility::get_module_within(g_hooker->get_target()).value_or(nullptr) == module) {
+        for (const auto& hook : g_hooker->get_hooks()) {
+            builder.add_hook((uint32_t)(g_hooker->get_target() - base), (uint32_t)hook->index, hook->count_only ? ScanCache::COUNT_ONLY : 0);
+        }
+    }
+
+    // A mapped file can't be replaced, let go of it first.
+    g_module_scan.cache.reset();
+
+    const auto path = get_scan_cache_path(module);
+
+    if (builder.write(path, get_module_identity(module))) {
+        spdlog::info("Wrote scan cache to {}", path.string());
+    } else {
+        spdlog::error("Failed to write scan cache to {}", path.string());
+    }
+
+    // Without a cache the vtables get scanned every frame instead.
+    open_scan_cache();
+}
+
+// Keeps the hooks saved in the module's cache in step with the live ones.
+void save_hooks(HMODULE module) {
+    if (module == g_module_scan.module && g_module_scan.cache.has_value()) {
+        write_scan_cache(false);
+    }
+}
+
+// Called when a module gets selected. The first time a module is seen it gets scanned and the
+// cache written, after that its vtables and saved hooks come straight from the cache.
+void load_scan_cache() {
+    if (open_scan_cache()) {
+        spdlog::info("Loaded scan cache for {} with {} vtables", selected_module_name, g_module_scan.validation.size());
+        reattach_cached_hooks();
+        return;
+    }
+
+    if (selected_module == nullptr) {
+        return;
+    }
+
+    spdlog::info("No scan cache for {}, scanning it", selected_module_name);
+    write_scan_cache(true);
+}
+
+void select_module(std::string name) {
+    selected_module_name = std::move(name);
+    selected_module = GetModuleHandleA(selected_module_name.c_str());
+
+    if (g_module_scan.module != selected_module) {
+        load_scan_cache();
+    }
+}
+
 void render_module_vtables() {
-    auto all_vtables = utility::rtti::find_all_vtables(selected_module);
+    const auto base = (uintptr_t)selected_module;
+    const auto& cache = g_module_scan.cache;
+
+    if (cache.has_value()) {
+        ImGui::Text("Scan cache: %zu vtables", cache->get_vtables().size());
+        ImGui::SameLine();
+
+        if (ImGui::Button("Save Scan Cache")) {
+            write_scan_cache(false);
+            return;
+        }
+
+        ImGui::SameLine();
+
+        if (ImGui::Button("Rebuild Scan Cache")) {
+            write_scan_cache(true);
+            return;
+        }
+    } else if (ImGui::Button("Build Scan Cache")) {
+        write_scan_cache(true);
+        return;
+    }
+
+    // Either straight from the cache, or scanned every frame without one.
+    struct Entry {
+        uintptr_t vtable{};
+        std::string_view name{};
+        std::optional<size_t> cache_index{};
+    };
+
+    std::vector<Entry> all_vtables{};
+
+    if (cache.has_value()) {
+        const auto vtables = cache->get_vtables();
+        all_vtables.reserve(vtables.size());
+
+        for (size_t i = 0; i < vtables.size(); ++i) {
+            if (g_module_scan.validation[i] != ModuleScan::Validation::STALE) {
+                all_vtables.push_back(Entry{base + vtables[i].rva, cache->get_name(vtables[i]), i});
+            }
+        }
+    } else {
+        for (const auto vtable : utility::rtti::find_all_vtables(selected_module)) {
+            const auto ti = utility::rtti::get_type_info(&vtable);
+            all_vtables.push_back(Entry{vtable, (ti != nullptr && ti->name() != nullptr) ? ti->name() : ""});
+        }
+    }
 
     if (all_vtables.empty()) {
         ImGui::Text("No vtables found in the module!");
@@ -116,9 +451,8 @@ void render_module_vtables() {
 
     // Filter the vtables
     if (should_search) {
-        std::erase_if(all_vtables, [&](const uintptr_t vtable) {
-            const auto ti = utility::rtti::get_type_info(&vtable);
-            return ti == nullptr || ti->name() == nullptr || std::string_view{ti->name()}.find(search_view) == std::string_view::npos;
+        std::erase_if(all_vtables, [&](const Entry& entry) {
+            return entry.name.find(search_view) == std::string_view::npos;
         });
     }
 
@@ -136,35 +470,43 @@ void render_module_vtables() {
     ImGui::NextColumn();
     ImGui::Separator();
 
-    static std::unordered_map<uintptr_t, size_t> vtable_counts{};
-    static std::unordered_map<uintptr_t, std::vector<uintptr_t>> vtable_references{};
-
-    for (const auto vtable : all_vtables) {
+    for (const auto& [vtable, name, cache_index] : all_vtables) {
         ImGui::PushID((void*)vtable);
 
         utility::ScopeGuard guard { []() {
             ImGui::PopID();
         }};
 
-        const auto ti = utility::rtti::get_type_info(&vtable);
-        //ImGui::Text("%s", (ti != nullptr && ti->name() != nullptr) ? ti->name() : "Unknown");
-        if (ImGui::TreeNode((ti != nullptr && ti->name() != nullptr) ? ti->name() : "Unknown")) {
-            auto it = vtable_references.find(vtable);
+        const auto label = name.empty() ? std::string{"Unknown"} : std::string{name};
+        if (ImGui::TreeNode(label.c_str())) {
+            auto it = g_vtable_references.find(vtable);
+
+            if (it == g_vtable_references.end() && (!cache_index.has_value() || validate_cached_vtable(*cache_index))) {
+                std::vector<uintptr_t> references{};
+                const auto cached = cache_index.has_value() ? cache->get_references(cache->get_vtables()[*cache_index]) : std::nullopt;
 
-            if (it == vtable_references.end()) {
-                vtable_references[vtable] = utility::scan_displacement_references(selected_module, vtable);
-                it = vtable_references.find(vtable);
+                if (cached.has_value()) {
+                    for (const auto rva : *cached) {
+                        references.push_back(base + rva);
+                    }
+                } else {
+                    references = utility::scan_displacement_references(selected_module, vtable);
+                }
+
+                it = g_vtable_references.emplace(vtable, std::move(references)).first;
             }
 
-            for (const auto ref : it->second) {
-                ImGui::Selectable(std::format("0x{:x}", ref).c_str());
+            if (it != g_vtable_references.end()) {
+                for (const auto ref : it->second) {
+                    ImGui::Selectable(std::format("0x{:x}", ref).c_str());
 
-                if (ImGui::BeginPopupContextItem()) {
-                    if (ImGui::MenuItem("Copy to clipboard")) {
-                        copy_to_clipboard(std::format("0x{:x}", ref));
-                    }
+                    if (ImGui::BeginPopupContextItem()) {
+                        if (ImGui::MenuItem("Copy to clipboard")) {
+                            copy_to_clipboard(std::format("0x{:x}", ref));
+                        }
 
-                    ImGui::EndPopup();
+                        ImGui::EndPopup();
+                    }
                 }
             }
 
@@ -172,11 +514,13 @@ void render_module_vtables() {
         }
         ImGui::NextColumn();
         size_t count = 0;
-        if (vtable_counts.contains(vtable)) {
-            count = vtable_counts[vtable];
+        if (cache_index.has_value()) {
+            count = cache->get_vtables()[*cache_index].count;
+        } else if (g_vtable_counts.contains(vtable)) {
+            count = g_vtable_counts[vtable];
         } else {
             count = Hooker::count((uintptr_t*)vtable);
-            vtable_counts[vtable] = count;
+            g_vtable_counts[vtable] = count;
         }
 
         ImGui::Text("%zu", count);
@@ -184,14 +528,114 @@ void render_module_vtables() {
         ImGui::Text("0x%llx", vtable);
         ImGui::NextColumn();
         ImGui::PushID((void*)vtable);
-        if (ImGui::Button("Hook")) {
+        if (ImGui::Button("Hook") && (!cache_index.has_value() || validate_cached_vtable(*cache_index)) && can_hook_vtable(vtable)) {
+            g_hooker.reset(); // Off before the new hooks go on, they may share functions with the old ones.
             g_hooker = std::make_unique<Hooker>((uintptr_t*)vtable);
+
+            // Remember the hook set for the next time the cache gets loaded.
+            if (cache.has_value()) {
+                ImGui::PopID();
+                save_hooks(selected_module);
+                return;
+            }
         }
         ImGui::PopID();
         ImGui::NextColumn();
     }
 }
 
+void render_survey() {
+    if (g_survey == nullptr) {
+        if (ImGui::Button("Survey Module") && can_survey_module(selected_module)) {
+            g_survey = std::make_unique<Survey>(selected_module);
+        }
+
+        ImGui::Text("Hooks every virtual function in %s with a count-only stub.", selected_module_name.c_str());
+        return;
+    }
+
+    if (ImGui::Button("Stop Survey")) {
+        g_survey.reset();
+        return;
+    }
+
+    ImGui::SameLine();
+
+    if (ImGui::Button("Capture Hot")) {
+        spdlog::info("Attached capture to {} hot functions", g_survey->capture_hot());
+    }
+
+    const auto memory = g_survey->get_memory_usage();
+    ImGui::Text("Functions: %zu, Slots: %zu, Hot: %zu, Memory: %zu KB (%zu bytes per hook)",
+        g_survey->size(), g_survey->get_slot_count(), g_survey->get_hot_count(), memory / 1024, g_survey->size() > 0 ? memory / g_survey->size() : 0);
+
+    render_rate_resolution();
+
+    const auto rates = g_survey->get_rates();
+
+    if (rates == nullptr) {
+        return;
+    }
+
+    // The tracker's top K from its last tick, already sorted. Nothing here scales with the module.
+    const auto top = rates->get_top();
+
+    // Layout: Function | Calls | Address | Capture
+    ImGui::Columns(4, "survey", true);
+    ImGui::Separator();
+    ImGui::Text("Function");
+    ImGui::NextColumn();
+    ImGui::Text("Calls");
+    ImGui::NextColumn();
+    ImGui::Text("Address");
+    ImGui::NextColumn();
+    ImGui::Text("Capture");
+    ImGui::NextColumn();
+    ImGui::Separator();
+
+    for (const auto& entry : *top) {
+        const auto id = entry.id;
+        ImGui::PushID((int)id);
+
+        utility::ScopeGuard guard { []() {
+            ImGui::PopID();
+        }};
+
+        const auto vtable = g_survey->get_vtable(id);
+        const auto ti = utility::rtti::get_type_info(&vtable);
+        const auto name = (ti != nullptr && ti->name() != nullptr) ? ti->name() : "Unknown";
+        const auto capture = g_survey->get_capture(id);
+
+        if (capture != nullptr) {
+            if (ImGui::TreeNode(std::format("{}[{}]", name, g_survey->get_index(id)).c_str())) {
+                for (const auto addr : capture->get_callstack()) {
+                    ImGui::TextUnformatted(g_symbols->format(addr).c_str());
+                }
+
+                ImGui::TreePop();
+            }
+        } else {
+            ImGui::Text("%s[%u]", name, g_survey->get_index(id));
+        }
+
+        ImGui::NextColumn();
+        ImGui::Text("%llu", g_survey->get_calls(id));
+        ImGui::SetNextItemWidth(-1);
+        render_rate(rates, id);
+        ImGui::NextColumn();
+        ImGui::Text("0x%llx", g_survey->get_target(id));
+        ImGui::NextColumn();
+
+        if (capture == nullptr && ImGui::Button("Capture")) {
+            g_survey->capture(id);
+        }
+
+        ImGui::NextColumn();
+    }
+
+    ImGui::Columns(1);
+}
+
 bool render_gui() {
     ImGuiLogSink::get()->render_log_window();
 
@@ -213,7 +657,41 @@ bool render_gui() {
             }
 
             const auto& hooks = g_hooker->get_hooks();
+            const auto hooked_module = utility::get_module_within(target).value_or(nullptr);
+
+            if (ImGui::Button("All Count Only")) {
+                for (const auto& hook : hooks) {
+                    hook->set_count_only(true);
+                }
+
+                save_hooks(hooked_module);
+            }
+
+            ImGui::SameLine();
+
+            if (ImGui::Button("All Full Capture")) {
+                for (const auto& hook : hooks) {
+                    hook->set_count_only(false);
+                }
+
+                save_hooks(hooked_module);
+            }
+
+            ImGui::SameLine();
+
+            if (ImGui::Button("Unhook")) {
+                g_hooker.reset();
+                save_hooks(hooked_module);
+                ImGui::End();
+                return !open;
+            }
             
+            render_rate_resolution();
+
+            render_hottest(g_hooker->get_rates(), [&](uint32_t id) {
+                return std::format("Index {}", hooks[id]->index);
+            });
+
             ImGui::Columns(4, "hooks", true);
             ImGui::Separator();
             ImGui::Text("Index");
@@ -226,7 +704,9 @@ bool render_gui() {
             ImGui::NextColumn();
             ImGui::Separator();
 
-            for (const auto& hook : hooks) {
+            for (size_t i = 0; i < hooks.size(); ++i) {
+                const auto& hook = hooks[i];
+
                 //ImGui::Text("%zu", hook->index);
                 if (ImGui::TreeNode(std::format("{}", hook->index).c_str())) {
                     const auto last_context = hook->get_last_context();
@@ -264,28 +744,18 @@ bool render_gui() {
                     ImGui::TreePop();
                 }
                 ImGui::NextColumn();
-                ImGui::Text("%zu", hook->calls.load());
+                ImGui::Text("%zu", hook->get_calls());
+                ImGui::PushID((int)i);
+                ImGui::SetNextItemWidth(-1);
+                render_rate(g_hooker->get_rates(), (uint32_t)i);
+                ImGui::PopID();
                 ImGui::NextColumn();
                 //ImGui::Text("0x%llx", hook->last_return_address.load());
-                if (ImGui::TreeNode(std::format("0x{:x}", hook->last_return_address.load()).c_str())) {
+                if (ImGui::TreeNode(std::format("0x{:x}", hook->get_last_return_address()).c_str())) {
                     const auto callstack = hook->get_callstack();
 
                     for (const auto addr : callstack) {
-                        const auto module_within = utility::get_module_within(addr);
-
-                        if (module_within) {
-                            const auto rel = addr - (uintptr_t)*module_within;
-                            const auto module_path = utility::get_module_path(*module_within);
-
-                            if (module_path.has_value()) {
-                                const auto module_name = module_path->substr(module_path->find_last_of('\\') + 1);
-                                ImGui::Text("%s+0x%llx", module_name.c_str(), rel);
-                            } else {
-                                ImGui::Text("0x%llx", addr);
-                            }
-                        } else {
-                            ImGui::Text("0x%llx", addr);
-                        }
+                        ImGui::TextUnformatted(g_symbols->format(addr).c_str());
                     }
 
                     ImGui::TreePop();
@@ -302,6 +772,14 @@ bool render_gui() {
                     hook->restore();
                 }
 
+                ImGui::SameLine();
+
+                bool count_only = hook->count_only;
+                if (ImGui::Checkbox("Count Only", &count_only)) {
+                    hook->set_count_only(count_only);
+                    save_hooks(hooked_module);
+                }
+
                 ImGui::PopID();
                 ImGui::NextColumn();
             }
@@ -314,8 +792,7 @@ bool render_gui() {
         auto modules = utility::get_loaded_module_names();
 
         if (selected_module_name.empty() && !modules.empty()) {
-            selected_module_name = utility::narrow(modules[0]); // Usually the first module is the executable.
-            selected_module = GetModuleHandleA(selected_module_name.c_str());
+            select_module(utility::narrow(modules[0])); // Usually the first module is the executable.
         }
 
         std::sort(modules.begin(), modules.end());
@@ -327,8 +804,7 @@ bool render_gui() {
                 const auto narrow_module = utility::narrow(module);
                 bool is_selected = (selected_module_name == narrow_module);
                 if (ImGui::Selectable(narrow_module.c_str(), is_selected)) {
-                    selected_module_name = narrow_module;
-                    selected_module = GetModuleHandleA(selected_module_name.c_str());
+                    select_module(narrow_module);
                 }
                 if (is_selected) {
                     ImGui::SetItemDefaultFocus();
@@ -337,6 +813,18 @@ bool render_gui() {
             ImGui::EndCombo();
         }
 
+        // Symbols for modules without a PDB, e.g. exported from a disassembler.
+        static char map_file_path[MAX_PATH]{};
+        ImGui::InputText("Map File", map_file_path, sizeof(map_file_path));
+
+        if (ImGui::Button("Load Map File")) {
+            if (g_symbols->load_map_file(selected_module_name, map_file_path)) {
+                spdlog::info("Loaded map file {} for {}", map_file_path, selected_module_name);
+            } else {
+                spdlog::error("Failed to load map file {}", map_file_path);
+            }
+        }
+
         ImGui::End();
     }
 
@@ -348,6 +836,14 @@ bool render_gui() {
         ImGui::End();
     }
 
+    ImGui::SetNextWindowSize(ImVec2(500, 400), ImGuiCond_FirstUseEver);
+
+    if (ImGui::Begin("Module Survey")) {
+        render_survey();
+
+        ImGui::End();
+    }
+
     return !open;
 }
 
@@ -395,7 +891,14 @@ void start_gui() {
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 130");
 
+    g_symbols = std::make_unique<SymbolResolver>();
+
     auto cleanupguard = utility::ScopeGuard { [&window]() {
+        // These all join a worker thread, which can't happen during DLL detach.
+        g_survey.reset();
+        g_hooker.reset();
+        g_symbols.reset();
+
         ImGui_ImplOpenGL3_Shutdown();
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();
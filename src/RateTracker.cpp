@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <chrono>
+
+#include "RateTracker.hpp"
+
+namespace {
+// Moves every row of a ring to a wider stride.
+void widen(std::vector<float>& ring, size_t length, size_t old_stride, size_t new_stride) {
+    std::vector<float> result(length * new_stride);
+
+    for (size_t pos = 0; pos < length; ++pos) {
+        std::copy_n(ring.begin() + pos * old_stride, old_stride, result.begin() + pos * new_stride);
+    }
+
+    ring = std::move(result);
+}
+
+// Min-heap on rate, so the coldest of the current top K is at the front.
+bool hotter(const RateTracker::Entry& a, const RateTracker::Entry& b) {
+    return a.rate > b.rate || (a.rate == b.rate && a.id < b.id);
+}
+
+// Averages every series over a whole ring into one sample of the next coarser ring.
+void downsample(const std::vector<float>& ring, size_t length, size_t stride, std::span<float> out) {
+    const auto n = out.size();
+    std::fill(out.begin(), out.end(), 0.0f);
+
+    for (size_t pos = 0; pos < length; ++pos) {
+        const auto row = ring.data() + pos * stride;
+
+        for (size_t id = 0; id < n; ++id) {
+            out[id] += row[id];
+        }
+    }
+
+    for (auto& value : out) {
+        value /= (float)length;
+    }
+}
+}
+
+RateTracker::RateTracker(size_t count, Source source, size_t top_k, bool start_thread)
+    : m_source{std::move(source)},
+    m_top_k{top_k},
+    m_series(count, UNTRACKED),
+    m_counts(count)
+{
+    m_heap.reserve(top_k);
+
+    if (start_thread) {
+        m_thread = std::jthread{[this](std::stop_token stop) { run(stop); }};
+    }
+}
+
+RateTracker::~RateTracker() {
+    if (m_thread.joinable()) {
+        m_thread.request_stop();
+        m_thread.join();
+    }
+}
+
+void RateTracker::tick(float seconds) {
+    const auto n = size();
+
+    m_source(m_counts);
+    m_heap.clear();
+
+    {
+        std::unique_lock _{m_mutex};
+
+        for (size_t id = 0; id < n; ++id) {
+            auto series = m_series[id];
+
+            if (series == UNTRACKED) {
+                if (m_counts[id] == 0) {
+                    continue;
+                }
+
+                series = track((uint32_t)id);
+            }
+
+            const auto delta = m_counts[id] - m_last_counts[series];
+            const auto rate = seconds > 0.0f ? (float)delta / seconds : 0.0f;
+
+            m_last_counts[series] = m_counts[id];
+            m_seconds[m_second_pos * m_capacity + series] = rate;
+
+            if (rate <= 0.0f || m_top_k == 0) {
+                continue;
+            }
+
+            const Entry entry{(uint32_t)id, rate};
+
+            if (m_heap.size() < m_top_k) {
+                m_heap.push_back(entry);
+                std::push_heap(m_heap.begin(), m_heap.end(), hotter);
+            } else if (hotter(entry, m_heap.front())) {
+                std::pop_heap(m_heap.begin(), m_heap.end(), hotter);
+                m_heap.back() = entry;
+                std::push_heap(m_heap.begin(), m_heap.end(), hotter);
+            }
+        }
+
+        m_second_pos = (m_second_pos + 1) % SECONDS;
+        ++m_ticks;
+
+        // Downsample once the finer ring has wrapped around.
+        if (m_ticks % SECONDS == 0) {
+            downsample(m_seconds, SECONDS, m_capacity, {m_minutes.data() + m_minute_pos * m_capacity, m_ids.size()});
+
+            m_minute_pos = (m_minute_pos + 1) % MINUTES;
+
+            if (m_ticks % (SECONDS * MINUTES) == 0) {
+                downsample(m_minutes, MINUTES, m_capacity, {m_hours.data() + m_hour_pos * m_capacity, m_ids.size()});
+
+                m_hour_pos = (m_hour_pos + 1) % HOURS;
+            }
+        }
+    }
+
+    // Only K entries get sorted, and only once per tick.
+    auto top = std::make_shared<std::vector<Entry>>(m_heap);
+    std::sort(top->begin(), top->end(), hotter);
+    m_top.store(std::move(top));
+}
+
+uint32_t RateTracker::track(uint32_t id) {
+    const auto series = (uint32_t)m_ids.size();
+
+    if (series == m_capacity) {
+        const auto capacity = std::max<size_t>(m_capacity * 2, 16);
+
+        widen(m_seconds, SECONDS, m_capacity, capacity);
+        widen(m_minutes, MINUTES, m_capacity, capacity);
+        widen(m_hours, HOURS, m_capacity, capacity);
+        m_capacity = capacity;
+    }
+
+    m_series[id] = series;
+    m_ids.push_back(id);
+    m_last_counts.push_back(0); // Counts start at zero, so the first sample is everything since the last tick.
+
+    return series;
+}
+
+float RateTracker::get_rate(uint32_t id) const {
+    std::shared_lock _{m_mutex};
+
+    if (const auto series = m_series[id]; series != UNTRACKED) {
+        return m_seconds[((m_second_pos + SECONDS - 1) % SECONDS) * m_capacity + series];
+    }
+
+    return 0.0f;
+}
+
+std::vector<uint32_t> RateTracker::get_tracked() const {
+    std::shared_lock _{m_mutex};
+    return m_ids;
+}
+
+RateTracker::Series RateTracker::get_series(uint32_t id, Resolution resolution) const {
+    Series result{};
+    std::shared_lock _{m_mutex};
+
+    const auto series = m_series[id];
+
+    const auto copy = [&](const std::vector<float>& ring, size_t length, size_t pos) {
+        if (series != UNTRACKED) {
+            for (size_t i = 0; i < length; ++i) {
+                result.values[i] = ring[i * m_capacity + series];
+            }
+        }
+
+        result.size = (int)length;
+        result.offset = (int)pos; // The next write position is the oldest sample.
+    };
+
+    switch (resolution) {
+    case Resolution::SECONDS:
+        copy(m_seconds, SECONDS, m_second_pos);
+        break;
+    case Resolution::MINUTES:
+        copy(m_minutes, MINUTES, m_minute_pos);
+        break;
+    case Resolution::HOURS:
+        copy(m_hours, HOURS, m_hour_pos);
+        break;
+    }
+
+    return result;
+}
+
+size_t RateTracker::get_memory_usage() const {
+    std::shared_lock _{m_mutex};
+
+    return sizeof(RateTracker) +
+        (m_series.capacity() + m_ids.capacity()) * sizeof(uint32_t) +
+        (m_seconds.capacity() + m_minutes.capacity() + m_hours.capacity()) * sizeof(float) +
+        (m_counts.capacity() + m_last_counts.capacity()) * sizeof(uint64_t) +
+        m_heap.capacity() * sizeof(Entry) * 2; // The heap and the published copy.
+}
+
+void RateTracker::run(std::stop_token stop) {
+    using clock = std::chrono::steady_clock;
+
+    auto last = clock::now();
+    auto next = last + std::chrono::seconds{1};
+
+    while (true) {
+        {
+            std::unique_lock lock{m_thread_mutex};
+
+            // Nothing notifies the cv, it only wakes up early when stopping.
+            m_thread_cv.wait_until(lock, stop, next, [] { return false; });
+        }
+
+        if (stop.stop_requested()) {
+            break;
+        }
+
+        const auto now = clock::now();
+        tick(std::chrono::duration<float>(now - last).count());
+
+        last = now;
+        next += std::chrono::seconds{1};
+
+        // Don't try to catch up after a stall, just start over from now.
+        if (next < now) {
+            next = now + std::chrono::seconds{1};
+        }
+    }
+}
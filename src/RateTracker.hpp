@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Call rates over time for a fixed set of hooks, sampled by a background thread so the hooks
+// themselves only ever bump their counter.
+//
+// Every tracked series has three rings: 60 per-second samples, 60 per-minute samples (the average of
+// each minute's seconds) and 24 per-hour samples (the average of each hour's minutes). Rates are in
+// calls per second.
+//
+// A hook only gets a series once its counter first goes above zero, so a module survey where most
+// functions are never called pays 12 bytes per cold hook rather than a full set of rings. Series are
+// numbered in the order their hooks were first called, which doubles as the list of hot hooks.
+// All series share the same ring positions and each ring is one flat array indexed by
+// position * capacity + series, so a tick writes one contiguous row.
+//
+// Each tick also picks the hottest series by their last per-second rate with a bounded min-heap,
+// O(n log K) instead of sorting everything, and publishes them as an immutable snapshot.
+class RateTracker {
+public:
+    enum class Resolution {
+        SECONDS,
+        MINUTES,
+        HOURS,
+    };
+
+    static constexpr size_t SECONDS{60};
+    static constexpr size_t MINUTES{60};
+    static constexpr size_t HOURS{24};
+
+    // Fills counts[id] with the cumulative call count of every hook. Counts start at zero.
+    using Source = std::function<void(std::span<uint64_t> counts)>;
+
+    struct Entry {
+        uint32_t id{};
+        float rate{};
+    };
+
+    // A copy of one ring, laid out for ImGui::PlotLines. values[offset] is the oldest sample.
+    struct Series {
+        std::array<float, SECONDS> values{};
+        int size{};
+        int offset{};
+    };
+
+    // The thread samples once a second, without it tick has to be called manually.
+    RateTracker(size_t count, Source source, size_t top_k = 16, bool start_thread = true);
+    virtual ~RateTracker();
+
+    RateTracker(const RateTracker&) = delete;
+    RateTracker& operator=(const RateTracker&) = delete;
+
+    // Takes one per-second sample of every series, seconds being the time since the last one.
+    void tick(float seconds);
+
+    // Number of hooks.
+    size_t size() const {
+        return m_counts.size();
+    }
+
+    // The last per-second sample, 0 for hooks that were never called.
+    float get_rate(uint32_t id) const;
+
+    // All zeroes for hooks that were never called.
+    Series get_series(uint32_t id, Resolution resolution) const;
+
+    // Every hook that has been called, in the order they were first seen.
+    std::vector<uint32_t> get_tracked() const;
+
+    size_t get_tracked_count() const {
+        std::shared_lock _{m_mutex};
+        return m_ids.size();
+    }
+
+    // Hottest first, only hooks that were called in the last second.
+    std::shared_ptr<const std::vector<Entry>> get_top() const {
+        return m_top.load();
+    }
+
+    size_t get_memory_usage() const;
+
+private:
+    static constexpr uint32_t UNTRACKED{0xFFFFFFFF};
+
+    void run(std::stop_token stop);
+
+    // Starts a series for id. Only called by tick, with m_mutex held.
+    uint32_t track(uint32_t id);
+
+    Source m_source{};
+    size_t m_top_k{};
+
+    mutable std::shared_mutex m_mutex{}; // Guards the series against readers while a tick writes them.
+    std::vector<uint32_t> m_series{}; // Indexed by hook id, UNTRACKED until it's called.
+    std::vector<uint32_t> m_ids{}; // Indexed by series.
+    std::vector<uint64_t> m_last_counts{}; // Indexed by series.
+    size_t m_capacity{}; // Series the rings have room for.
+    std::vector<float> m_seconds{};
+    std::vector<float> m_minutes{};
+    std::vector<float> m_hours{};
+    size_t m_second_pos{}; // Next sample goes here.
+    size_t m_minute_pos{};
+    size_t m_hour_pos{};
+    uint64_t m_ticks{};
+
+    // Only touched by tick.
+    std::vector<uint64_t> m_counts{};
+    std::vector<Entry> m_heap{};
+
+    std::atomic<std::shared_ptr<const std::vector<Entry>>> m_top{std::make_shared<const std::vector<Entry>>()};
+
+    std::mutex m_thread_mutex{};
+    std::condition_variable_any m_thread_cv{};
+    std::jthread m_thread{}; // Last, so it's stopped before anything it uses goes away.
+};
@@ -0,0 +1,199 @@
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "ScanCache.hpp"
+
+namespace {
+constexpr char MAGIC[8]{'V', 'T', 'M', 'C', 'A', 'C', 'H', 'E'};
+
+// Maps the whole file read-only. The returned pointer unmaps it when released.
+std::pair<std::shared_ptr<const uint8_t>, size_t> map_file(const std::filesystem::path& path) {
+#ifdef _WIN32
+    auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return {};
+    }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return {};
+    }
+
+    auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+
+    if (mapping == nullptr) {
+        return {};
+    }
+
+    auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping); // The view keeps the mapping alive.
+
+    if (view == nullptr) {
+        return {};
+    }
+
+    return {std::shared_ptr<const uint8_t>{(const uint8_t*)view, [](const uint8_t* p) { UnmapViewOfFile(p); }}, (size_t)size.QuadPart};
+#else
+    const auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return {};
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return {};
+    }
+
+    const auto size = (size_t)st.st_size;
+    auto view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file alive.
+
+    if (view == MAP_FAILED) {
+        return {};
+    }
+
+    return {std::shared_ptr<const uint8_t>{(const uint8_t*)view, [size](const uint8_t* p) { munmap((void*)p, size); }}, size};
+#endif
+}
+
+// Whether [offset, offset + count * elem_size) fits in a file of file_size bytes, with the given alignment.
+bool section_in_bounds(uint64_t offset, uint64_t count, uint64_t elem_size, uint64_t alignment, size_t file_size) {
+    if (offset % alignment != 0 || offset > file_size) {
+        return false;
+    }
+
+    return count <= (file_size - offset) / elem_size;
+}
+
+size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+}
+
+std::optional<ScanCache> ScanCache::open(const std::filesystem::path& path, const ModuleIdentity& identity) {
+    auto [mapping, size] = map_file(path);
+
+    if (mapping == nullptr || size < sizeof(Header)) {
+        return std::nullopt;
+    }
+
+    const auto& header = *(const Header*)mapping.get();
+
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || header.identity != identity) {
+        return std::nullopt;
+    }
+
+    if (!section_in_bounds(header.vtables_offset, header.vtable_count, sizeof(VTable), alignof(VTable), size) ||
+        !section_in_bounds(header.references_offset, header.reference_count, sizeof(uint32_t), alignof(uint32_t), size) ||
+        !section_in_bounds(header.hooks_offset, header.hook_count, sizeof(Hook), alignof(Hook), size) ||
+        !section_in_bounds(header.strings_offset, header.string_size, 1, 1, size))
+    {
+        return std::nullopt;
+    }
+
+    return ScanCache{std::move(mapping)};
+}
+
+std::string_view ScanCache::get_name(const VTable& vtable) const {
+    const auto& header = get_header();
+
+    if ((uint64_t)vtable.name_offset + vtable.name_size > header.string_size) {
+        return {};
+    }
+
+    return {(const char*)(m_data + header.strings_offset + vtable.name_offset), vtable.name_size};
+}
+
+std::optional<std::span<const uint32_t>> ScanCache::get_references(const VTable& vtable) const {
+    const auto& header = get_header();
+
+    if (vtable.references_offset == UNKNOWN || (uint64_t)vtable.references_offset + vtable.references_count > header.reference_count) {
+        return std::nullopt;
+    }
+
+    const auto references = (const uint32_t*)(m_data + header.references_offset);
+    return std::span<const uint32_t>{references + vtable.references_offset, vtable.references_count};
+}
+
+void ScanCache::Builder::add_vtable(uint32_t rva, uint32_t count, std::string_view name, std::optional<std::span<const uint32_t>> references) {
+    auto& vtable = m_vtables.emplace_back();
+    vtable.rva = rva;
+    vtable.count = count;
+    vtable.name_offset = (uint32_t)m_strings.size();
+    vtable.name_size = (uint32_t)name.size();
+    m_strings += name;
+
+    if (references.has_value()) {
+        vtable.references_offset = (uint32_t)m_references.size();
+        vtable.references_count = (uint32_t)references->size();
+        m_references.insert(m_references.end(), references->begin(), references->end());
+    }
+}
+
+void ScanCache::Builder::add_hook(uint32_t vtable_rva, uint32_t index, uint32_t flags) {
+    m_hooks.push_back(Hook{vtable_rva, index, flags});
+}
+
+bool ScanCache::Builder::write(const std::filesystem::path& path, const ModuleIdentity& identity) const {
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.identity = identity;
+    header.vtable_count = (uint32_t)m_vtables.size();
+    header.reference_count = (uint32_t)m_references.size();
+    header.hook_count = (uint32_t)m_hooks.size();
+    header.string_size = (uint32_t)m_strings.size();
+
+    // Every section starts 8 byte aligned.
+    header.vtables_offset = align_up(sizeof(Header), 8);
+    header.references_offset = align_up(header.vtables_offset + m_vtables.size() * sizeof(VTable), 8);
+    header.hooks_offset = align_up(header.references_offset + m_references.size() * sizeof(uint32_t), 8);
+    header.strings_offset = align_up(header.hooks_offset + m_hooks.size() * sizeof(Hook), 8);
+
+    std::vector<uint8_t> data(header.strings_offset + m_strings.size());
+
+    auto copy_section = [&](uint64_t offset, const void* src, size_t size) {
+        if (size > 0) {
+            std::memcpy(data.data() + offset, src, size);
+        }
+    };
+
+    copy_section(0, &header, sizeof(header));
+    copy_section(header.vtables_offset, m_vtables.data(), m_vtables.size() * sizeof(VTable));
+    copy_section(header.references_offset, m_references.data(), m_references.size() * sizeof(uint32_t));
+    copy_section(header.hooks_offset, m_hooks.data(), m_hooks.size() * sizeof(Hook));
+    copy_section(header.strings_offset, m_strings.data(), m_strings.size());
+
+    std::error_code ec{};
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    auto tmp_path = path;
+    tmp_path += ".tmp";
+
+    {
+        std::ofstream file{tmp_path, std::ios::binary | std::ios::trunc};
+        if (!file) {
+            return false;
+        }
+
+        file.write((const char*)data.data(), (std::streamsize)data.size());
+        if (!file) {
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tmp_path, path, ec);
+    return !ec;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// On-disk cache of a module's vtable scan, so startup doesn't have to redo find_all_vtables,
+// Hooker::count, the RTTI name lookups and scan_displacement_references every injection.
+//
+// The file is a flat little-endian image that gets memory mapped and used in place, nothing is parsed:
+//  Header | VTable[vtable_count] | uint32_t references[reference_count] | Hook[hook_count] | char strings[string_size]
+//
+// Everything in it is an RVA or an offset into the file. It's only valid for the module build it
+// was made from, which is checked against the module's size and link timestamp when opening.
+// Only the header and section bounds are checked up front, records are bounds checked when read.
+class ScanCache {
+public:
+    static constexpr uint32_t VERSION{1};
+    static constexpr uint32_t UNKNOWN{0xFFFFFFFF}; // references_offset when the references were never scanned.
+
+    struct ModuleIdentity {
+        uint64_t size{};
+        uint64_t timestamp{};
+
+        bool operator==(const ModuleIdentity&) const = default;
+    };
+
+    struct Header {
+        char magic[8]{};
+        uint32_t version{};
+        uint32_t reserved{};
+        ModuleIdentity identity{};
+        uint32_t vtable_count{};
+        uint32_t reference_count{};
+        uint32_t hook_count{};
+        uint32_t string_size{};
+        uint64_t vtables_offset{};
+        uint64_t references_offset{};
+        uint64_t hooks_offset{};
+        uint64_t strings_offset{};
+    };
+
+    struct VTable {
+        uint32_t rva{};
+        uint32_t count{}; // Hooker::count
+        uint32_t name_offset{};
+        uint32_t name_size{};
+        uint32_t references_offset{UNKNOWN}; // Index into the references section.
+        uint32_t references_count{};
+    };
+
+    enum HookFlags : uint32_t {
+        COUNT_ONLY = 1 << 0,
+    };
+
+    // A hook to re-attach when the cache is loaded.
+    struct Hook {
+        uint32_t vtable_rva{};
+        uint32_t index{};
+        uint32_t flags{};
+    };
+
+    static_assert(sizeof(Header) == 80);
+    static_assert(sizeof(VTable) == 24);
+    static_assert(sizeof(Hook) == 12);
+
+    // Maps the cache at path. Returns nullopt if it doesn't exist, is malformed or was made
+    // from a different build of the module.
+    static std::optional<ScanCache> open(const std::filesystem::path& path, const ModuleIdentity& identity);
+
+    std::span<const VTable> get_vtables() const {
+        return {(const VTable*)(m_data + get_header().vtables_offset), get_header().vtable_count};
+    }
+
+    std::span<const Hook> get_hooks() const {
+        return {(const Hook*)(m_data + get_header().hooks_offset), get_header().hook_count};
+    }
+
+    // Empty if the name is out of bounds.
+    std::string_view get_name(const VTable& vtable) const;
+
+    // nullopt if the references were never scanned, or are out of bounds.
+    std::optional<std::span<const uint32_t>> get_references(const VTable& vtable) const;
+
+    const Header& get_header() const {
+        return *(const Header*)m_data;
+    }
+
+    // Collects a scan in memory and writes it out in the mapped format.
+    class Builder {
+    public:
+        void add_vtable(uint32_t rva, uint32_t count, std::string_view name, std::optional<std::span<const uint32_t>> references);
+        void add_hook(uint32_t vtable_rva, uint32_t index, uint32_t flags);
+
+        // Writes to a temporary file first and then replaces path with it.
+        bool write(const std::filesystem::path& path, const ModuleIdentity& identity) const;
+
+    private:
+        std::vector<VTable> m_vtables{};
+        std::vector<uint32_t> m_references{};
+        std::vector<Hook> m_hooks{};
+        std::string m_strings{};
+    };
+
+private:
+    ScanCache(std::shared_ptr<const uint8_t> mapping)
+        : m_mapping{std::move(mapping)},
+        m_data{m_mapping.get()}
+    {
+    }
+
+    std::shared_ptr<const uint8_t> m_mapping{}; // Unmaps the file when the last copy goes away.
+    const uint8_t* m_data{};
+};
@@ -0,0 +1,226 @@
+#include <memory>
+
+#include <utility/Module.hpp>
+
+#include "Survey.hpp"
+
+namespace {
+size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+}
+
+Survey::Survey(HMODULE module)
+    : m_module(module)
+{
+    spdlog::info("Surveying module at 0x{:x}", (uintptr_t)module);
+
+    const auto vtables = utility::rtti::find_all_vtables(module);
+
+    // Only needed while assigning ids.
+    std::unordered_map<uintptr_t, uint32_t> ids{};
+    std::vector<uintptr_t> targets{};
+
+    for (const auto vtable : vtables) {
+        Hooker::for_each((uintptr_t*)vtable, [&](uintptr_t fn, size_t index) {
+            auto [it, inserted] = ids.try_emplace(fn, (uint32_t)targets.size());
+
+            if (inserted) {
+                targets.push_back(fn);
+                m_owner_vtables.push_back(vtable);
+                m_owner_indices.push_back((uint32_t)index);
+            }
+
+            m_slots.push_back(&((uintptr_t*)vtable)[index]);
+            m_slot_ids.push_back(it->second);
+        });
+    }
+
+    if (targets.empty()) {
+        spdlog::warn("No virtual functions found in module at 0x{:x}", (uintptr_t)module);
+        return;
+    }
+
+    SYSTEM_INFO si{};
+    GetSystemInfo(&si);
+
+    const auto code_size = align_up(targets.size() * STUB_STRIDE, si.dwPageSize);
+    const auto calls_size = align_up(targets.size() * sizeof(uint64_t), si.dwPageSize);
+    const auto originals_size = align_up(targets.size() * sizeof(uintptr_t), si.dwPageSize);
+
+    m_block_size = code_size + calls_size + originals_size;
+    m_block = (uint8_t*)VirtualAlloc(nullptr, m_block_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+    if (m_block == nullptr) {
+        spdlog::error("Failed to allocate {} bytes for the survey", m_block_size);
+        abandon();
+        return;
+    }
+
+    m_code = m_block;
+    m_calls = (std::atomic<uint64_t>*)(m_block + code_size);
+    std::uninitialized_value_construct_n(m_calls, targets.size());
+    m_originals = (uintptr_t*)(m_block + code_size + calls_size);
+
+    for (uint32_t id = 0; id < targets.size(); ++id) {
+        m_originals[id] = targets[id];
+
+        // Everything is in one block so the stubs always come out compact, anything else wouldn't fit the stride.
+        if (const auto size = CountStub::emit(m_code + id * STUB_STRIDE, &m_calls[id], nullptr, &m_originals[id]); size == 0 || size > STUB_STRIDE) {
+            spdlog::error("Survey stub for 0x{:x} is {} bytes, expected at most {}", targets[id], size, STUB_STRIDE);
+            abandon();
+            return;
+        }
+    }
+
+    DWORD old_protect{};
+    if (!VirtualProtect(m_code, code_size, PAGE_EXECUTE_READ, &old_protect)) {
+        spdlog::error("Failed to set memory protection for survey stubs at 0x{:x}", (uintptr_t)m_code);
+    }
+
+    FlushInstructionCache(GetCurrentProcess(), m_code, code_size);
+
+    patch_slots(false);
+
+    m_rates = std::make_unique<RateTracker>(size(), [this](std::span<uint64_t> counts) {
+        for (uint32_t id = 0; id < size(); ++id) {
+            counts[id] = get_calls(id);
+        }
+    }, TOP_K);
+
+    spdlog::info("Survey hooked {} functions through {} vtable slots, {} bytes per hook", size(), m_slots.size(), get_memory_usage() / size());
+}
+
+Survey::~Survey() {
+    spdlog::info("Ending survey of module at 0x{:x}", (uintptr_t)m_module);
+
+    m_rates.reset();
+    patch_slots(true);
+    m_captures.clear();
+
+    // Restoring the slots doesn't get threads out of the stubs. One can be inside a stub right now, or
+    // have loaded a slot before it was restored and not have called through it yet, and there's no way
+    // to tell when the last of them is done. So the block is never freed. The stubs still count and
+    // jump to the original functions, and it's only about 32 bytes per function.
+    if (m_block != nullptr) {
+        spdlog::info("Leaving {} bytes of survey stubs mapped", m_block_size);
+    }
+}
+
+void Survey::abandon() {
+    if (m_block != nullptr) {
+        VirtualFree(m_block, 0, MEM_RELEASE);
+    }
+
+    m_block = nullptr;
+    m_block_size = 0;
+    m_code = nullptr;
+    m_calls = nullptr;
+    m_originals = nullptr;
+    m_owner_vtables.clear();
+    m_owner_indices.clear();
+    m_slots.clear();
+    m_slot_ids.clear();
+}
+
+void Survey::patch_slots(bool restore) {
+    uintptr_t current_page{};
+    DWORD old_protect{};
+
+    // The slots are mostly in order, so only change protection when moving to another page.
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        const auto slot = m_slots[i];
+        const auto page = (uintptr_t)slot & ~(uintptr_t)0xFFF;
+
+        if (page != current_page) {
+            if (current_page != 0) {
+                VirtualProtect((void*)current_page, 0x1000, old_protect, &old_protect);
+            }
+
+            if (!VirtualProtect((void*)page, 0x1000, PAGE_EXECUTE_READWRITE, &old_protect)) {
+                spdlog::error("Failed to set memory protection for vtable slot at 0x{:x}", (uintptr_t)slot);
+                current_page = 0;
+                continue;
+            }
+
+            current_page = page;
+        }
+
+        const auto id = m_slot_ids[i];
+        const auto value = restore ? m_originals[id] : (uintptr_t)(m_code + id * STUB_STRIDE);
+
+        ((std::atomic<uintptr_t>*)slot)->store(value);
+    }
+
+    if (current_page != 0) {
+        VirtualProtect((void*)current_page, 0x1000, old_protect, &old_protect);
+    }
+}
+
+std::vector<uint32_t> Survey::get_hot() const {
+    // The tracker already keeps the called hooks apart, no need to scan every counter.
+    if (m_rates == nullptr) {
+        return {};
+    }
+
+    return m_rates->get_tracked();
+}
+
+size_t Survey::get_memory_usage() const {
+    size_t result = sizeof(Survey) + m_block_size;
+
+    if (m_rates != nullptr) {
+        result += m_rates->get_memory_usage();
+    }
+
+    result += m_owner_vtables.capacity() * sizeof(uintptr_t);
+    result += m_owner_indices.capacity() * sizeof(uint32_t);
+    result += m_slots.capacity() * sizeof(uintptr_t*);
+    result += m_slot_ids.capacity() * sizeof(uint32_t);
+
+    for (const auto& [id, hook] : m_captures) {
+        result += sizeof(Hooker::Hook) + Hooker::STUB_SIZE + hook->get_callstack_capacity() * sizeof(uintptr_t);
+    }
+
+    return result;
+}
+
+std::shared_ptr<Hooker::Hook> Survey::capture(uint32_t id) {
+    if (id >= size()) {
+        return nullptr;
+    }
+
+    if (auto existing = get_capture(id); existing != nullptr) {
+        return existing;
+    }
+
+    // Two MidHooks on the same function can't be taken off in any order but the reverse of how they went on,
+    // and the Hooker and the survey come and go independently. Whichever went second would restore the
+    // other's jump, into a trampoline that may already be freed.
+    if (g_hooker != nullptr && g_hooker->find_hook_by_target(m_originals[id]) != nullptr) {
+        spdlog::warn("Can't capture survey hook {} at 0x{:x}, it's already hooked by the Hook Manager", id, m_originals[id]);
+        return nullptr;
+    }
+
+    auto hook = Hooker::create_hook(nullptr, m_originals[id], m_owner_indices[id]);
+
+    if (auto err = hook->impl.enable(); !err.has_value()) {
+        spdlog::error("Failed to enable capture for survey hook: {}, error: {}", id, (int32_t)err.error().type);
+        return nullptr;
+    }
+
+    m_captures[id] = hook;
+    return hook;
+}
+
+size_t Survey::capture_hot() {
+    size_t result{};
+
+    for (const auto id : get_hot()) {
+        if (!m_captures.contains(id) && capture(id) != nullptr) {
+            ++result;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <windows.h>
+
+#include "Hooker.hpp"
+#include "RateTracker.hpp"
+
+// Counts calls to every virtual function of every vtable in a module.
+//
+// Unlike Hooker, this patches the vtable slots themselves rather than the function bodies,
+// so it only sees calls that go through a vtable, but it needs no trampolines and no per-hook objects.
+// Every unique function gets a dense hook id (shared base methods get one id for all their slots),
+// and the per-hook state lives in flat arrays indexed by that id.
+//
+// Full capture state (a Hooker::Hook) is only allocated on demand, for hooks that have been called.
+class Survey {
+public:
+    Survey(HMODULE module);
+    virtual ~Survey();
+
+    // Number of hook ids (unique functions).
+    size_t size() const {
+        return m_owner_vtables.size();
+    }
+
+    size_t get_slot_count() const {
+        return m_slots.size();
+    }
+
+    HMODULE get_module() const {
+        return m_module;
+    }
+
+    uint64_t get_calls(uint32_t id) const {
+        return m_calls[id].load(std::memory_order_relaxed);
+    }
+
+    uintptr_t get_target(uint32_t id) const {
+        return m_originals[id];
+    }
+
+    // The first vtable the function was found in, and its index there.
+    uintptr_t get_vtable(uint32_t id) const {
+        return m_owner_vtables[id];
+    }
+
+    uint32_t get_index(uint32_t id) const {
+        return m_owner_indices[id];
+    }
+
+    // Indexed by hook id. Null if nothing was hooked.
+    RateTracker* get_rates() const {
+        return m_rates.get();
+    }
+
+    // Ids of every hook that has been called at least once, in the order they were first called.
+    // Comes from the rate tracker, so it can lag the counters by up to a second.
+    std::vector<uint32_t> get_hot() const;
+
+    size_t get_hot_count() const {
+        return m_rates != nullptr ? m_rates->get_tracked_count() : 0;
+    }
+
+    // Total bytes used by the survey, including the stub block.
+    size_t get_memory_usage() const;
+
+    // Attaches full capture to a hook, returns the existing one if already captured.
+    // Refuses functions g_hooker already hooks, see capture.
+    std::shared_ptr<Hooker::Hook> capture(uint32_t id);
+
+    // Attaches full capture to every hook that has been called. Returns how many were added.
+    size_t capture_hot();
+
+    // Whether a capture is attached to the function at target.
+    bool is_captured(uintptr_t target) const {
+        for (const auto& [id, hook] : m_captures) {
+            if (hook->target == target) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    std::shared_ptr<Hooker::Hook> get_capture(uint32_t id) const {
+        if (auto it = m_captures.find(id); it != m_captures.end()) {
+            return it->second;
+        }
+
+        return nullptr;
+    }
+
+private:
+    static constexpr size_t STUB_STRIDE{16}; // Compact CountStub without a return address is 14 bytes.
+    static constexpr size_t TOP_K{100}; // Rows in the GUI's table.
+
+    // Frees the block and forgets every hook, for when the survey fails before anything was patched.
+    void abandon();
+    void patch_slots(bool restore);
+
+    HMODULE m_module{};
+
+    // One allocation holding, each on their own pages: the stub code, the call counters and the jump targets.
+    // It outlives the survey, see ~Survey.
+    // Keeping them together keeps the stubs in the compact rip-relative form.
+    // The counters are packed rather than cache-line isolated, density matters more here.
+    uint8_t* m_block{};
+    size_t m_block_size{};
+    uint8_t* m_code{};
+    std::atomic<uint64_t>* m_calls{};
+    uintptr_t* m_originals{};
+
+    // Indexed by hook id.
+    std::vector<uintptr_t> m_owner_vtables{};
+    std::vector<uint32_t> m_owner_indices{};
+
+    // Indexed by slot, every vtable entry that was redirected.
+    std::vector<uintptr_t*> m_slots{};
+    std::vector<uint32_t> m_slot_ids{};
+
+    std::unique_ptr<RateTracker> m_rates{};
+
+    // Cold, only for hooks that were asked to capture.
+    std::unordered_map<uint32_t, std::shared_ptr<Hooker::Hook>> m_captures{};
+};
+
+static inline std::unique_ptr<Survey> g_survey{};
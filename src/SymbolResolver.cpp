@@ -0,0 +1,566 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <format>
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <dbghelp.h>
+#include <tlhelp32.h>
+
+#include <spdlog/spdlog.h>
+#include <utility/String.hpp>
+#else
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <link.h>
+#endif
+
+#include "SymbolResolver.hpp"
+
+namespace {
+std::string to_lower(std::string_view s) {
+    std::string result{s};
+    std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    return result;
+}
+
+std::vector<std::string_view> split(std::string_view line) {
+    std::vector<std::string_view> result{};
+
+    while (true) {
+        const auto start = line.find_first_not_of(" \t\r");
+        if (start == std::string_view::npos) {
+            break;
+        }
+
+        line.remove_prefix(start);
+        const auto end = std::min(line.find_first_of(" \t\r"), line.size());
+        result.push_back(line.substr(0, end));
+        line.remove_prefix(end);
+    }
+
+    return result;
+}
+
+// The whole token has to be hex, with or without a 0x prefix.
+std::optional<uintptr_t> parse_hex(std::string_view s) {
+    if (s.starts_with("0x") || s.starts_with("0X")) {
+        s.remove_prefix(2);
+    }
+
+    uintptr_t result{};
+    const auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), result, 16);
+
+    if (s.empty() || ec != std::errc{} || end != s.data() + s.size()) {
+        return std::nullopt;
+    }
+
+    return result;
+}
+
+#ifdef _WIN32
+// Not in the SDK headers.
+using LdrDllNotificationFunction = VOID (NTAPI*)(ULONG reason, const void* data, PVOID context);
+using LdrRegisterDllNotificationFn = LONG (NTAPI*)(ULONG flags, LdrDllNotificationFunction callback, PVOID context, PVOID* cookie);
+using LdrUnregisterDllNotificationFn = LONG (NTAPI*)(PVOID cookie);
+
+template<typename T>
+T get_ntdll_export(const char* name) {
+    const auto ntdll = GetModuleHandleW(L"ntdll.dll");
+    return ntdll != nullptr ? (T)GetProcAddress(ntdll, name) : nullptr;
+}
+#else
+// Bumped by the dynamic linker whenever an object is loaded or unloaded.
+uint64_t get_load_generation() {
+    uint64_t result{};
+
+    dl_iterate_phdr([](dl_phdr_info* info, size_t size, void* data) -> int {
+        *(uint64_t*)data = info->dlpi_adds + info->dlpi_subs;
+        return 1;
+    }, &result);
+
+    return result;
+}
+#endif
+}
+
+SymbolResolver::ModuleSnapshot::ModuleSnapshot(std::vector<Module> modules)
+    : m_modules{std::move(modules)}
+{
+    std::sort(m_modules.begin(), m_modules.end(), [](const Module& a, const Module& b) {
+        return a.start < b.start;
+    });
+}
+
+const SymbolResolver::Module* SymbolResolver::ModuleSnapshot::find(uintptr_t addr) const {
+    auto it = std::upper_bound(m_modules.begin(), m_modules.end(), addr, [](uintptr_t addr, const Module& m) {
+        return addr < m.start;
+    });
+
+    if (it == m_modules.begin()) {
+        return nullptr;
+    }
+
+    --it;
+    return addr < it->end ? &*it : nullptr;
+}
+
+std::optional<SymbolResolver::SymbolMap> SymbolResolver::SymbolMap::load(const std::filesystem::path& path) {
+    std::ifstream file{path};
+    if (!file) {
+        return std::nullopt;
+    }
+
+    SymbolMap result{};
+    std::optional<uintptr_t> preferred_base{}; // Only set for MSVC linker maps.
+    std::string line{};
+
+    while (std::getline(file, line)) {
+        const auto tokens = split(line);
+
+        if (tokens.size() < 2 || tokens[0].starts_with('#') || tokens[0].starts_with(';')) {
+            continue;
+        }
+
+        // " Preferred load address is 0000000140000000"
+        if (tokens.size() == 5 && tokens[0] == "Preferred" && tokens[3] == "is") {
+            preferred_base = parse_hex(tokens[4]);
+            continue;
+        }
+
+        if (preferred_base.has_value()) {
+            // " 0001:00000000       ?foo@@YAXXZ       0000000140001000 f   foo.obj"
+            // The section:offset column is useless without the section table, the Rva+Base one isn't.
+            if (tokens.size() < 3 || tokens[0].find(':') == std::string_view::npos) {
+                continue;
+            }
+
+            const auto va = parse_hex(tokens[2]);
+            if (!va.has_value() || *va < *preferred_base) {
+                continue;
+            }
+
+            result.m_symbols.emplace_back(*va - *preferred_base, std::string{tokens[1]});
+        } else {
+            // "1a2b30 Foo::bar(int)", the name can have spaces in it.
+            const auto rva = parse_hex(tokens[0]);
+            if (!rva.has_value()) {
+                continue;
+            }
+
+            const auto name_start = (size_t)(tokens[1].data() - line.data());
+            const auto name_end = line.find_last_not_of(" \t\r") + 1;
+            result.m_symbols.emplace_back(*rva, line.substr(name_start, name_end - name_start));
+        }
+    }
+
+    std::stable_sort(result.m_symbols.begin(), result.m_symbols.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    // Keep the first name given for an address.
+    const auto last = std::unique(result.m_symbols.begin(), result.m_symbols.end(), [](const auto& a, const auto& b) {
+        return a.first == b.first;
+    });
+
+    result.m_symbols.erase(last, result.m_symbols.end());
+    return result;
+}
+
+std::optional<SymbolResolver::Symbol> SymbolResolver::SymbolMap::find(uintptr_t rva) const {
+    auto it = std::upper_bound(m_symbols.begin(), m_symbols.end(), rva, [](uintptr_t rva, const auto& s) {
+        return rva < s.first;
+    });
+
+    if (it == m_symbols.begin()) {
+        return std::nullopt;
+    }
+
+    --it;
+    return Symbol{it->second, rva - it->first};
+}
+
+SymbolResolver::SymbolResolver(bool start_worker) {
+    refresh_modules();
+
+#ifdef _WIN32
+    // Called with the loader lock held, so just flag it and let the worker rebuild the snapshot.
+    const auto on_dll_notification = [](ULONG reason, const void* data, PVOID context) {
+        auto resolver = (SymbolResolver*)context;
+
+        std::scoped_lock _{resolver->m_pending_mutex};
+        resolver->m_modules_dirty = true;
+        resolver->m_pending_cv.notify_one();
+    };
+
+    if (const auto ldr_register = get_ntdll_export<LdrRegisterDllNotificationFn>("LdrRegisterDllNotification"); ldr_register != nullptr) {
+        if (ldr_register(0, on_dll_notification, this, &m_notification_cookie) != 0) {
+            spdlog::warn("Failed to register for DLL notifications, module list won't update");
+            m_notification_cookie = nullptr;
+        }
+    }
+#endif
+
+    if (start_worker) {
+        m_worker = std::jthread{[this](std::stop_token stop) { worker(stop); }};
+    }
+}
+
+SymbolResolver::~SymbolResolver() {
+#ifdef _WIN32
+    if (m_notification_cookie != nullptr) {
+        if (const auto ldr_unregister = get_ntdll_export<LdrUnregisterDllNotificationFn>("LdrUnregisterDllNotification"); ldr_unregister != nullptr) {
+            ldr_unregister(m_notification_cookie);
+        }
+    }
+#endif
+
+    if (m_worker.joinable()) {
+        m_worker.request_stop();
+        m_worker.join();
+    }
+
+#ifdef _WIN32
+    if (m_platform_initialized) {
+        SymCleanup(m_symbol_process);
+    }
+
+    if (m_symbol_process != nullptr) {
+        CloseHandle(m_symbol_process);
+    }
+#endif
+}
+
+void SymbolResolver::refresh_modules() {
+#ifndef _WIN32
+    // Before enumerating, so anything loaded in between still counts as a change.
+    m_load_generation = get_load_generation();
+#endif
+
+    set_modules(enumerate_modules());
+
+#ifdef _WIN32
+    std::scoped_lock _{m_platform_mutex};
+
+    if (m_platform_initialized) {
+        SymRefreshModuleList(m_symbol_process);
+    }
+#endif
+}
+
+void SymbolResolver::set_modules(std::vector<Module> modules) {
+    const auto next = std::make_shared<const ModuleSnapshot>(std::move(modules));
+    const auto prev = m_modules.exchange(next);
+
+    // Drop cached symbols for anything that isn't in the same module anymore (unloaded, or something else loaded there).
+    const auto same_module = [](const Module* a, const Module* b) {
+        return a == b || (a != nullptr && b != nullptr && a->start == b->start && a->end == b->end && a->name == b->name);
+    };
+
+    std::unique_lock _{m_cache_mutex};
+
+    std::erase_if(m_cache, [&](const auto& entry) {
+        return !same_module(prev->find(entry.first), next->find(entry.first));
+    });
+}
+
+std::string SymbolResolver::format(uintptr_t addr) {
+    const auto modules = get_modules();
+    const auto module = modules->find(addr);
+
+    if (module == nullptr) {
+        return std::format("0x{:x}", addr);
+    }
+
+    const auto rel = addr - module->start;
+
+    {
+        std::shared_lock _{m_cache_mutex};
+
+        if (auto it = m_cache.find(addr); it != m_cache.end()) {
+            const auto& symbol = it->second;
+
+            if (!symbol.has_value()) {
+                return std::format("{}+0x{:x}", module->name, rel);
+            }
+
+            if (symbol->displacement == 0) {
+                return std::format("{}!{}", module->name, symbol->name);
+            }
+
+            return std::format("{}!{}+0x{:x}", module->name, symbol->name, symbol->displacement);
+        }
+    }
+
+    {
+        std::scoped_lock _{m_pending_mutex};
+
+        if (m_pending_set.insert(addr).second) {
+            m_pending.push_back(addr);
+            m_pending_cv.notify_one();
+        }
+    }
+
+    return std::format("{}+0x{:x}", module->name, rel);
+}
+
+std::optional<SymbolResolver::Symbol> SymbolResolver::lookup(uintptr_t addr) const {
+    std::shared_lock _{m_cache_mutex};
+
+    if (auto it = m_cache.find(addr); it != m_cache.end()) {
+        return it->second;
+    }
+
+    return std::nullopt;
+}
+
+bool SymbolResolver::load_map_file(std::string_view module_name, const std::filesystem::path& path) {
+    auto map = SymbolMap::load(path);
+
+    if (!map.has_value() || map->size() == 0) {
+        return false;
+    }
+
+    const auto key = to_lower(module_name);
+
+    {
+        std::unique_lock _{m_maps_mutex};
+        m_maps[key] = std::make_shared<const SymbolMap>(std::move(*map));
+    }
+
+    // Whatever was resolved for the module before has to be redone with the map.
+    const auto modules = get_modules();
+    std::unique_lock _{m_cache_mutex};
+
+    std::erase_if(m_cache, [&](const auto& entry) {
+        const auto module = modules->find(entry.first);
+        return module != nullptr && to_lower(module->name) == key;
+    });
+
+    return true;
+}
+
+void SymbolResolver::resolve_pending() {
+    std::vector<uintptr_t> batch{};
+    std::vector<std::pair<uintptr_t, std::optional<Symbol>>> resolved{};
+
+    while (true) {
+        {
+            std::scoped_lock _{m_pending_mutex};
+
+            const auto count = std::min(m_pending.size(), BATCH_SIZE);
+            batch.assign(m_pending.end() - count, m_pending.end());
+            m_pending.resize(m_pending.size() - count);
+        }
+
+        if (batch.empty()) {
+            break;
+        }
+
+        const auto modules = get_modules();
+        resolved.clear();
+
+        for (const auto addr : batch) {
+            resolved.emplace_back(addr, resolve(addr, modules->find(addr)));
+        }
+
+        {
+            std::unique_lock _{m_cache_mutex};
+
+            for (auto& [addr, symbol] : resolved) {
+                m_cache.insert_or_assign(addr, std::move(symbol));
+            }
+        }
+
+        // Only forget about them once they're in the cache, so format doesn't queue them again in between.
+        std::scoped_lock _{m_pending_mutex};
+
+        for (const auto addr : batch) {
+            m_pending_set.erase(addr);
+        }
+    }
+}
+
+void SymbolResolver::worker(std::stop_token stop) {
+    while (!stop.stop_requested()) {
+        {
+            std::unique_lock lock{m_pending_mutex};
+            const auto ready = [this] { return !m_pending.empty() || m_modules_dirty; };
+
+#ifdef _WIN32
+            if (!m_pending_cv.wait(lock, stop, ready)) {
+                break;
+            }
+#else
+            // Addresses in a module that isn't in the snapshot yet never get queued, so nothing would wake us up for it.
+            m_pending_cv.wait_for(lock, stop, std::chrono::seconds{1}, ready);
+
+            if (stop.stop_requested()) {
+                break;
+            }
+#endif
+        }
+
+#ifndef _WIN32
+        // No load notifications here, but checking the generation is cheap.
+        if (get_load_generation() != m_load_generation) {
+            m_modules_dirty = true;
+        }
+#endif
+
+        if (m_modules_dirty.exchange(false)) {
+            refresh_modules();
+        }
+
+        resolve_pending();
+    }
+}
+
+std::optional<SymbolResolver::Symbol> SymbolResolver::resolve(uintptr_t addr, const Module* module) {
+    if (module != nullptr) {
+        std::shared_ptr<const SymbolMap> map{};
+
+        {
+            std::shared_lock _{m_maps_mutex};
+
+            if (auto it = m_maps.find(to_lower(module->name)); it != m_maps.end()) {
+                map = it->second;
+            }
+        }
+
+        if (map != nullptr) {
+            if (auto symbol = map->find(addr - module->start); symbol.has_value()) {
+                return symbol;
+            }
+        }
+    }
+
+    return resolve_platform(addr);
+}
+
+#ifdef _WIN32
+std::optional<SymbolResolver::Symbol> SymbolResolver::resolve_platform(uintptr_t addr) {
+    std::scoped_lock _{m_platform_mutex};
+
+    // DbgHelp loads PDBs from the symbol path and falls back to export names when there aren't any.
+    if (!m_platform_initialized) {
+        // Options are process-wide, not per session, so they're left alone if the host already has a
+        // session of its own. Names get undecorated by hand below if SYMOPT_UNDNAME isn't on.
+        char search_path[MAX_PATH]{};
+        if (!SymGetSearchPath(GetCurrentProcess(), search_path, sizeof(search_path))) {
+            SymSetOptions(SymGetOptions() | SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS | SYMOPT_FAIL_CRITICAL_ERRORS);
+        } else {
+            spdlog::info("DbgHelp is already in use by the host, keeping its options");
+        }
+
+        // DbgHelp keys sessions by handle value, and the host (or its crash handler) may already have one
+        // on GetCurrentProcess(). A duplicate is a real handle to the same process with a value of its own,
+        // so SymInitialize can still enumerate modules and SymCleanup only tears down ours.
+        if (m_symbol_process == nullptr &&
+            !DuplicateHandle(GetCurrentProcess(), GetCurrentProcess(), GetCurrentProcess(), &m_symbol_process, 0, FALSE, DUPLICATE_SAME_ACCESS))
+        {
+            spdlog::error("Failed to duplicate process handle for DbgHelp, error: {}", GetLastError());
+            m_symbol_process = nullptr;
+            return std::nullopt;
+        }
+
+        if (!SymInitialize(m_symbol_process, nullptr, TRUE)) {
+            spdlog::error("Failed to initialize DbgHelp, error: {}", GetLastError());
+            return std::nullopt;
+        }
+
+        m_platform_initialized = true;
+    }
+
+    alignas(SYMBOL_INFO) uint8_t buffer[sizeof(SYMBOL_INFO) + MAX_SYM_NAME]{};
+    auto info = (SYMBOL_INFO*)buffer;
+    info->SizeOfStruct = sizeof(SYMBOL_INFO);
+    info->MaxNameLen = MAX_SYM_NAME;
+
+    DWORD64 displacement{};
+    if (!SymFromAddr(m_symbol_process, addr, &displacement, info)) {
+        return std::nullopt;
+    }
+
+    if ((SymGetOptions() & SYMOPT_UNDNAME) == 0 && info->NameLen > 0 && info->Name[0] == '?') {
+        char undecorated[MAX_SYM_NAME]{};
+
+        if (UnDecorateSymbolName(info->Name, undecorated, sizeof(undecorated), UNDNAME_NAME_ONLY) != 0) {
+            return Symbol{undecorated, (uintptr_t)displacement};
+        }
+    }
+
+    return Symbol{std::string{info->Name, info->NameLen}, (uintptr_t)displacement};
+}
+
+std::vector<SymbolResolver::Module> SymbolResolver::enumerate_modules() {
+    std::vector<Module> result{};
+
+    const auto snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPMODULE, GetCurrentProcessId());
+    if (snapshot == INVALID_HANDLE_VALUE) {
+        spdlog::error("Failed to snapshot modules, error: {}", GetLastError());
+        return result;
+    }
+
+    MODULEENTRY32W entry{};
+    entry.dwSize = sizeof(entry);
+
+    for (auto ok = Module32FirstW(snapshot, &entry); ok; ok = Module32NextW(snapshot, &entry)) {
+        const auto start = (uintptr_t)entry.modBaseAddr;
+        result.push_back(Module{start, start + entry.modBaseSize, utility::narrow(entry.szModule)});
+    }
+
+    CloseHandle(snapshot);
+    return result;
+}
+#else
+std::optional<SymbolResolver::Symbol> SymbolResolver::resolve_platform(uintptr_t addr) {
+    Dl_info info{};
+
+    if (dladdr((void*)addr, &info) == 0 || info.dli_sname == nullptr) {
+        return std::nullopt;
+    }
+
+    auto status = 0;
+    auto demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+    Symbol result{status == 0 ? demangled : info.dli_sname, addr - (uintptr_t)info.dli_saddr};
+    std::free(demangled);
+
+    return result;
+}
+
+std::vector<SymbolResolver::Module> SymbolResolver::enumerate_modules() {
+    std::vector<Module> result{};
+
+    dl_iterate_phdr([](dl_phdr_info* info, size_t size, void* data) -> int {
+        uintptr_t start{UINTPTR_MAX};
+        uintptr_t end{};
+
+        for (auto i = 0; i < info->dlpi_phnum; ++i) {
+            const auto& phdr = info->dlpi_phdr[i];
+
+            if (phdr.p_type == PT_LOAD) {
+                start = std::min<uintptr_t>(start, info->dlpi_addr + phdr.p_vaddr);
+                end = std::max<uintptr_t>(end, info->dlpi_addr + phdr.p_vaddr + phdr.p_memsz);
+            }
+        }
+
+        if (start >= end) {
+            return 0;
+        }
+
+        // The main executable has no name here.
+        std::error_code ec{};
+        const auto path = info->dlpi_name != nullptr && info->dlpi_name[0] != '\0'
+            ? std::filesystem::path{info->dlpi_name}
+            : std::filesystem::read_symlink("/proc/self/exe", ec);
+
+        ((std::vector<Module>*)data)->push_back(Module{start, end, path.filename().string()});
+        return 0;
+    }, &result);
+
+    return result;
+}
+#endif
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Turns code addresses into "module!symbol+0x10" for the callstack views.
+//
+// Module ranges are an immutable sorted snapshot, swapped out whole when modules get loaded,
+// so finding an address's module is one atomic load and a binary search. Symbol names are resolved on a
+// worker thread in batches and cached per address, the UI thread only ever does cache lookups
+// and queues up whatever it hasn't seen yet.
+//
+// Names come from a user-supplied map file if there is one for the module, otherwise from
+// DbgHelp on Windows (PDB, falling back to exports) or dladdr elsewhere (ELF dynamic symbols).
+class SymbolResolver {
+public:
+    struct Module {
+        uintptr_t start{};
+        uintptr_t end{};
+        std::string name{};
+    };
+
+    class ModuleSnapshot {
+    public:
+        ModuleSnapshot() = default;
+        ModuleSnapshot(std::vector<Module> modules);
+
+        // The module containing addr, if any.
+        const Module* find(uintptr_t addr) const;
+
+        const auto& get_modules() const {
+            return m_modules;
+        }
+
+    private:
+        std::vector<Module> m_modules{}; // Sorted by start, no overlaps.
+    };
+
+    struct Symbol {
+        std::string name{};
+        uintptr_t displacement{}; // From the start of the symbol.
+    };
+
+    // Symbols loaded from a map file, sorted by RVA.
+    // Understands plain "<hex rva> <name>" lines and MSVC linker maps (/MAP).
+    class SymbolMap {
+    public:
+        static std::optional<SymbolMap> load(const std::filesystem::path& path);
+
+        // The closest symbol at or below rva.
+        std::optional<Symbol> find(uintptr_t rva) const;
+
+        size_t size() const {
+            return m_symbols.size();
+        }
+
+    private:
+        std::vector<std::pair<uintptr_t, std::string>> m_symbols{};
+    };
+
+    // Module-change notifications and the platform symbol source start with the resolver.
+    SymbolResolver(bool start_worker = true);
+    virtual ~SymbolResolver();
+
+    SymbolResolver(const SymbolResolver&) = delete;
+    SymbolResolver& operator=(const SymbolResolver&) = delete;
+
+    // Rebuilds the module snapshot from the process, or replaces it outright.
+    void refresh_modules();
+    void set_modules(std::vector<Module> modules);
+
+    std::shared_ptr<const ModuleSnapshot> get_modules() const {
+        return m_modules.load();
+    }
+
+    // Never blocks. "module!symbol+0x10" once resolved, "module+0x1234" until then,
+    // and "0x7ff612345678" outside of any module. Anything not cached yet is queued.
+    std::string format(uintptr_t addr);
+
+    // Cached result only. nullopt if not resolved yet, or if there's no symbol for it.
+    std::optional<Symbol> lookup(uintptr_t addr) const;
+
+    // Uses the map file for the module with that name (case insensitive) from now on.
+    bool load_map_file(std::string_view module_name, const std::filesystem::path& path);
+
+    // Resolves everything queued so far on the calling thread. What the worker does in a loop.
+    void resolve_pending();
+
+    size_t get_cache_size() const {
+        std::shared_lock _{m_cache_mutex};
+        return m_cache.size();
+    }
+
+private:
+    static constexpr size_t BATCH_SIZE{256};
+
+    void worker(std::stop_token stop);
+    std::optional<Symbol> resolve(uintptr_t addr, const Module* module);
+
+    // Platform symbol source (DbgHelp / dladdr).
+    std::optional<Symbol> resolve_platform(uintptr_t addr);
+    static std::vector<Module> enumerate_modules();
+
+    std::atomic<std::shared_ptr<const ModuleSnapshot>> m_modules{std::make_shared<const ModuleSnapshot>()};
+    std::atomic<bool> m_modules_dirty{};
+    std::atomic<uint64_t> m_load_generation{}; // What the snapshot was made from, only used without load notifications.
+
+    // nullopt entries are addresses that were resolved but have no symbol.
+    mutable std::shared_mutex m_cache_mutex{};
+    std::unordered_map<uintptr_t, std::optional<Symbol>> m_cache{};
+
+    std::mutex m_pending_mutex{};
+    std::condition_variable_any m_pending_cv{};
+    std::vector<uintptr_t> m_pending{};
+    std::unordered_set<uintptr_t> m_pending_set{};
+
+    std::shared_mutex m_maps_mutex{};
+    std::unordered_map<std::string, std::shared_ptr<const SymbolMap>> m_maps{}; // Lowercase module name.
+
+    void* m_notification_cookie{};
+
+    // DbgHelp isn't thread safe.
+    std::mutex m_platform_mutex{};
+    bool m_platform_initialized{};
+    void* m_symbol_process{}; // Our own handle to the process, so we get a DbgHelp session separate from the host's.
+
+    std::jthread m_worker{}; // Last, so it's stopped before anything it uses goes away.
+};
+
+static inline std::unique_ptr<SymbolResolver> g_symbols{};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdio>
+
+// Just enough of a test framework for the Linux test executables. A failed check is printed and
+// counted, the test keeps going, and main returns the count so ctest sees the failure.
+namespace tests {
+inline int failures{};
+}
+
+#define CHECK(expr) \
+    do { \
+        if (!(expr)) { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expr); \
+            ++tests::failures; \
+        } \
+    } while (false)
@@ -0,0 +1,197 @@
+// Tests for ScanCache's file format: a round trip through Builder and open, and the checks open
+// and the accessors do on files that don't match the module or have been cut short or tampered with.
+//
+// Usage: vtablemonitor-scancache-test
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "ScanCache.hpp"
+
+#include "Check.hpp"
+
+namespace {
+constexpr ScanCache::ModuleIdentity IDENTITY{0x123000, 0x5F000000};
+
+const auto g_path = std::filesystem::temp_directory_path() / "vtablemonitor-test" / "module.vtcache";
+
+std::vector<uint8_t> read_file(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+void write_file(const std::filesystem::path& path, const std::vector<uint8_t>& data) {
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    file.write((const char*)data.data(), (std::streamsize)data.size());
+}
+
+// Two vtables, one without scanned references, and two hooks.
+bool write_sample() {
+    constexpr std::array<uint32_t, 3> references{0x2000, 0x2100, 0x2200};
+
+    ScanCache::Builder builder{};
+    builder.add_vtable(0x1000, 12, "class Foo", references);
+    builder.add_vtable(0x1100, 3, "class Bar", std::nullopt);
+    builder.add_hook(0x1000, 4, ScanCache::COUNT_ONLY);
+    builder.add_hook(0x1100, 1, 0);
+
+    return builder.write(g_path, IDENTITY);
+}
+
+// Rewrites the sample with one header field changed, then tries to open it.
+template<typename T>
+std::optional<ScanCache> open_with(T ScanCache::Header::* field, T value) {
+    write_sample();
+
+    auto data = read_file(g_path);
+    ((ScanCache::Header*)data.data())->*field = value;
+    write_file(g_path, data);
+
+    return ScanCache::open(g_path, IDENTITY);
+}
+
+void test_round_trip() {
+    CHECK(write_sample());
+
+    // Nothing left behind from the write.
+    auto tmp_path = g_path;
+    tmp_path += ".tmp";
+    CHECK(!std::filesystem::exists(tmp_path));
+
+    const auto cache = ScanCache::open(g_path, IDENTITY);
+    CHECK(cache.has_value());
+
+    if (!cache.has_value()) {
+        return;
+    }
+
+    const auto& header = cache->get_header();
+    CHECK(header.version == ScanCache::VERSION);
+    CHECK(header.identity == IDENTITY);
+    CHECK(header.vtables_offset % 8 == 0 && header.references_offset % 8 == 0 && header.hooks_offset % 8 == 0);
+
+    const auto vtables = cache->get_vtables();
+    CHECK(vtables.size() == 2);
+
+    if (vtables.size() == 2) {
+        CHECK(vtables[0].rva == 0x1000 && vtables[0].count == 12);
+        CHECK(cache->get_name(vtables[0]) == "class Foo");
+
+        const auto references = cache->get_references(vtables[0]);
+        CHECK(references.has_value() && references->size() == 3 && (*references)[0] == 0x2000 && (*references)[2] == 0x2200);
+
+        CHECK(vtables[1].rva == 0x1100 && vtables[1].count == 3);
+        CHECK(cache->get_name(vtables[1]) == "class Bar");
+        CHECK(!cache->get_references(vtables[1]).has_value());
+    }
+
+    const auto hooks = cache->get_hooks();
+    CHECK(hooks.size() == 2);
+
+    if (hooks.size() == 2) {
+        CHECK(hooks[0].vtable_rva == 0x1000 && hooks[0].index == 4 && hooks[0].flags == ScanCache::COUNT_ONLY);
+        CHECK(hooks[1].vtable_rva == 0x1100 && hooks[1].index == 1 && hooks[1].flags == 0);
+    }
+
+    // An empty scan is still a valid cache.
+    CHECK(ScanCache::Builder{}.write(g_path, IDENTITY));
+
+    const auto empty = ScanCache::open(g_path, IDENTITY);
+    CHECK(empty.has_value() && empty->get_vtables().empty() && empty->get_hooks().empty());
+}
+
+void test_identity_mismatch() {
+    CHECK(write_sample());
+
+    CHECK(ScanCache::open(g_path, IDENTITY).has_value());
+    CHECK(!ScanCache::open(g_path, {IDENTITY.size + 0x1000, IDENTITY.timestamp}).has_value());
+    CHECK(!ScanCache::open(g_path, {IDENTITY.size, IDENTITY.timestamp + 1}).has_value());
+
+    CHECK(!open_with(&ScanCache::Header::version, ScanCache::VERSION + 1).has_value());
+
+    write_sample();
+    auto data = read_file(g_path);
+    data[0] = 'X';
+    write_file(g_path, data);
+    CHECK(!ScanCache::open(g_path, IDENTITY).has_value());
+
+    CHECK(!ScanCache::open(g_path.parent_path() / "missing.vtcache", IDENTITY).has_value());
+}
+
+void test_truncated() {
+    CHECK(write_sample());
+    const auto data = read_file(g_path);
+
+    // Every length short of the whole file, down to an empty one.
+    auto all_rejected = true;
+
+    for (size_t size = 0; size < data.size(); ++size) {
+        write_file(g_path, {data.begin(), data.begin() + size});
+        all_rejected = all_rejected && !ScanCache::open(g_path, IDENTITY).has_value();
+    }
+
+    CHECK(all_rejected);
+}
+
+void test_corrupt_bounds() {
+    // Sections that run past the end of the file, or don't start on their alignment.
+    CHECK(!open_with(&ScanCache::Header::vtable_count, 1000u).has_value());
+    CHECK(!open_with(&ScanCache::Header::reference_count, 0xFFFFFFFFu).has_value());
+    CHECK(!open_with(&ScanCache::Header::hook_count, 1000u).has_value());
+    CHECK(!open_with(&ScanCache::Header::string_size, 1000u).has_value());
+    CHECK(!open_with(&ScanCache::Header::vtables_offset, (uint64_t)0xFFFFFFFFFFFFFFF8).has_value());
+    CHECK(!open_with(&ScanCache::Header::references_offset, (uint64_t)1 << 40).has_value());
+    CHECK(!open_with(&ScanCache::Header::hooks_offset, (uint64_t)sizeof(ScanCache::Header) + 1).has_value());
+    CHECK(!open_with(&ScanCache::Header::strings_offset, (uint64_t)0xFFFFFFFFFFFFFFFF).has_value());
+
+    // The header is fine but a record points outside its section. Open only checks the header,
+    // the accessors have to catch these.
+    write_sample();
+    auto data = read_file(g_path);
+    const auto header = *(const ScanCache::Header*)data.data();
+    auto vtables = (ScanCache::VTable*)(data.data() + header.vtables_offset);
+
+    vtables[0].name_offset = header.string_size;
+    vtables[0].name_size = 1;
+    vtables[1].name_offset = 0xFFFFFFFF;
+    vtables[1].name_size = 0xFFFFFFFF;
+    vtables[0].references_offset = 1;
+    vtables[0].references_count = header.reference_count;
+    vtables[1].references_offset = 0xFFFFFFFE;
+    vtables[1].references_count = 0xFFFFFFFF;
+    write_file(g_path, data);
+
+    const auto cache = ScanCache::open(g_path, IDENTITY);
+    CHECK(cache.has_value());
+
+    if (cache.has_value()) {
+        const auto records = cache->get_vtables();
+        CHECK(cache->get_name(records[0]).empty());
+        CHECK(cache->get_name(records[1]).empty());
+        CHECK(!cache->get_references(records[0]).has_value());
+        CHECK(!cache->get_references(records[1]).has_value());
+    }
+}
+}
+
+int main() {
+    test_round_trip();
+    test_identity_mismatch();
+    test_truncated();
+    test_corrupt_bounds();
+
+    std::error_code ec{};
+    std::filesystem::remove_all(g_path.parent_path(), ec);
+
+    if (tests::failures == 0) {
+        std::printf("All ScanCache tests passed\n");
+    }
+
+    return tests::failures;
+}
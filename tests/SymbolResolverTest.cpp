@@ -0,0 +1,293 @@
+// Tests for SymbolResolver's portable core (module snapshots, map files, the cache and the pending
+// queue) on made-up modules, and for the dladdr / dl_iterate_phdr side on the test process itself.
+//
+// Usage: vtablemonitor-symbols-test
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <dlfcn.h>
+#include <link.h>
+
+#include "SymbolResolver.hpp"
+
+#include "Check.hpp"
+
+namespace {
+using Module = SymbolResolver::Module;
+using ModuleSnapshot = SymbolResolver::ModuleSnapshot;
+using SymbolMap = SymbolResolver::SymbolMap;
+
+std::filesystem::path write_file(std::string_view name, std::string_view contents) {
+    const auto path = std::filesystem::temp_directory_path() / name;
+    std::ofstream{path} << contents;
+    return path;
+}
+
+// Polls format until it contains expected, the worker gets there eventually.
+bool wait_for_format(SymbolResolver& resolver, uintptr_t addr, std::string_view expected) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (resolver.format(addr).find(expected) != std::string::npos) {
+            return true;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+
+    std::fprintf(stderr, "Gave up waiting for \"%.*s\", last got \"%s\"\n", (int)expected.size(), expected.data(), resolver.format(addr).c_str());
+    return false;
+}
+
+void test_module_snapshot() {
+    const ModuleSnapshot empty{};
+    CHECK(empty.find(0x1000) == nullptr);
+
+    // Given out of order, end is exclusive, and there's a gap between them.
+    const ModuleSnapshot snapshot{{{0x3000, 0x6000, "b.dll"}, {0x1000, 0x2000, "a.exe"}}};
+
+    CHECK(snapshot.find(0) == nullptr);
+    CHECK(snapshot.find(0xFFF) == nullptr);
+    CHECK(snapshot.find(0x1000) != nullptr && snapshot.find(0x1000)->name == "a.exe");
+    CHECK(snapshot.find(0x1FFF) != nullptr && snapshot.find(0x1FFF)->name == "a.exe");
+    CHECK(snapshot.find(0x2000) == nullptr);
+    CHECK(snapshot.find(0x2FFF) == nullptr);
+    CHECK(snapshot.find(0x3000) != nullptr && snapshot.find(0x3000)->name == "b.dll");
+    CHECK(snapshot.find(0x5FFF) != nullptr && snapshot.find(0x5FFF)->name == "b.dll");
+    CHECK(snapshot.find(0x6000) == nullptr);
+    CHECK(snapshot.find(UINTPTR_MAX) == nullptr);
+}
+
+void test_plain_map() {
+    const auto path = write_file("vtablemonitor-plain.map",
+        "# comment\n"
+        "; also a comment\n"
+        "\n"
+        "2000 baz\n"
+        "0x1000 Foo::bar(int, float)  \r\n"
+        "1000 duplicate\n"
+        "nothex name\n"
+        "3000\n");
+
+    const auto map = SymbolMap::load(path);
+    CHECK(map.has_value());
+
+    if (map.has_value()) {
+        CHECK(map->size() == 2);
+        CHECK(!map->find(0xFFF).has_value());
+
+        const auto bar = map->find(0x1000);
+        CHECK(bar.has_value() && bar->name == "Foo::bar(int, float)" && bar->displacement == 0);
+
+        const auto bar_inside = map->find(0x1FFF);
+        CHECK(bar_inside.has_value() && bar_inside->name == "Foo::bar(int, float)" && bar_inside->displacement == 0xFFF);
+
+        // Past the last symbol still resolves to it, there's no size to go by.
+        const auto baz = map->find(0x9000);
+        CHECK(baz.has_value() && baz->name == "baz" && baz->displacement == 0x7000);
+    }
+
+    std::filesystem::remove(path);
+
+    CHECK(!SymbolMap::load(std::filesystem::temp_directory_path() / "vtablemonitor-missing.map").has_value());
+}
+
+void test_msvc_map() {
+    const auto path = write_file("vtablemonitor-msvc.map",
+        " game\n"
+        "\n"
+        " Timestamp is 5f000000 (Sat Jul  4 00:00:00 2020)\n"
+        "\n"
+        " Preferred load address is 0000000140000000\n"
+        "\n"
+        " Start         Length     Name                   Class\n"
+        " 0001:00000000 00012345H .text                   CODE\n"
+        "\n"
+        "  Address         Publics by Value              Rva+Base               Lib:Object\n"
+        "\n"
+        " 0000:00000000       ___ImageBase               0000000140000000     <linker-defined>\n"
+        " 0001:00000100       ?bar@@YAXXZ                0000000140001100 f   foo.obj\n"
+        " 0001:00000000       ?foo@@YAXXZ                0000000140001000 f   foo.obj\n"
+        " 0000:00000000       __below_base               0000000130000000     <linker-defined>\n"
+        "\n"
+        " entry point at        0001:00000000\n");
+
+    const auto map = SymbolMap::load(path);
+    CHECK(map.has_value());
+
+    if (map.has_value()) {
+        CHECK(map->size() == 3);
+
+        const auto base = map->find(0x10);
+        CHECK(base.has_value() && base->name == "___ImageBase" && base->displacement == 0x10);
+
+        const auto foo = map->find(0x1000);
+        CHECK(foo.has_value() && foo->name == "?foo@@YAXXZ" && foo->displacement == 0);
+
+        const auto bar = map->find(0x1104);
+        CHECK(bar.has_value() && bar->name == "?bar@@YAXXZ" && bar->displacement == 4);
+    }
+
+    std::filesystem::remove(path);
+}
+
+void test_set_modules_invalidation() {
+    SymbolResolver resolver{false};
+    resolver.set_modules({{0x10000, 0x20000, "a.exe"}, {0x30000, 0x40000, "b.dll"}, {0x50000, 0x60000, "c.dll"}});
+
+    CHECK(resolver.format(0x70000) == "0x70000");
+    CHECK(resolver.format(0x10010) == "a.exe+0x10");
+    CHECK(resolver.format(0x30010) == "b.dll+0x10");
+    CHECK(resolver.format(0x50010) == "c.dll+0x10");
+
+    resolver.resolve_pending();
+    CHECK(resolver.get_cache_size() == 3);
+
+    // a.exe stays put, b.dll is unloaded and something else is loaded where c.dll was.
+    resolver.set_modules({{0x10000, 0x20000, "a.exe"}, {0x50000, 0x60000, "d.dll"}});
+
+    CHECK(resolver.get_cache_size() == 1);
+    CHECK(resolver.lookup(0x10010).has_value() == false); // Cached, but there's no symbol for it.
+    CHECK(resolver.format(0x30010) == "0x30010");
+    CHECK(resolver.format(0x50010) == "d.dll+0x10");
+}
+
+void test_map_file_invalidation() {
+    const auto path = write_file("vtablemonitor-invalidation.map", "0 start\n100 middle\n");
+
+    SymbolResolver resolver{false};
+    resolver.set_modules({{0x10000, 0x20000, "a.exe"}, {0x30000, 0x40000, "B.dll"}});
+
+    resolver.format(0x10110);
+    resolver.format(0x30110);
+    resolver.resolve_pending();
+
+    CHECK(resolver.get_cache_size() == 2);
+    CHECK(resolver.format(0x30110) == "B.dll+0x110");
+
+    CHECK(!resolver.load_map_file("b.dll", std::filesystem::temp_directory_path() / "vtablemonitor-missing.map"));
+    CHECK(resolver.get_cache_size() == 2);
+
+    // Case insensitive, and only b.dll's entries get dropped.
+    CHECK(resolver.load_map_file("b.dll", path));
+    CHECK(resolver.get_cache_size() == 1);
+
+    CHECK(resolver.format(0x30110) == "B.dll+0x110");
+    resolver.resolve_pending();
+    CHECK(resolver.format(0x30110) == "B.dll!middle+0x10");
+    CHECK(resolver.format(0x30100) == "B.dll+0x100");
+    resolver.resolve_pending();
+    CHECK(resolver.format(0x30100) == "B.dll!middle");
+    CHECK(resolver.format(0x10110) == "a.exe+0x110");
+
+    std::filesystem::remove(path);
+}
+
+void test_resolve_pending_batches() {
+    constexpr size_t COUNT{1000}; // A few batches' worth.
+
+    std::string contents{};
+
+    for (size_t i = 0; i < COUNT; ++i) {
+        char line[64]{};
+        std::snprintf(line, sizeof(line), "%zx fn%zu\n", i * 0x100, i);
+        contents += line;
+    }
+
+    const auto path = write_file("vtablemonitor-batches.map", contents);
+
+    SymbolResolver resolver{false};
+    resolver.set_modules({{0x100000, 0x200000, "a.exe"}});
+    CHECK(resolver.load_map_file("a.exe", path));
+
+    for (size_t i = 0; i < COUNT; ++i) {
+        resolver.format(0x100000 + i * 0x100 + 8);
+        resolver.format(0x100000 + i * 0x100 + 8); // Queued only once.
+    }
+
+    CHECK(resolver.get_cache_size() == 0);
+    resolver.resolve_pending();
+    CHECK(resolver.get_cache_size() == COUNT);
+
+    auto all_resolved = true;
+
+    for (size_t i = 0; i < COUNT; ++i) {
+        const auto symbol = resolver.lookup(0x100000 + i * 0x100 + 8);
+        all_resolved = all_resolved && symbol.has_value() && symbol->name == "fn" + std::to_string(i) && symbol->displacement == 8;
+    }
+
+    CHECK(all_resolved);
+
+    // Nothing left over.
+    resolver.resolve_pending();
+    CHECK(resolver.get_cache_size() == COUNT);
+
+    std::filesystem::remove(path);
+}
+
+void test_dladdr() {
+    SymbolResolver resolver{};
+
+    // libc's own, RTLD_DEFAULT can find a sanitizer's interceptor first.
+    const auto libc = dlopen("libc.so.6", RTLD_NOW | RTLD_NOLOAD);
+    CHECK(libc != nullptr);
+
+    if (libc == nullptr) {
+        return;
+    }
+
+    const auto fclose_addr = (uintptr_t)dlsym(libc, "fclose");
+    CHECK(fclose_addr != 0);
+    // glibc has aliases for it, any of them will do.
+    CHECK(wait_for_format(resolver, fclose_addr, "libc.so.6!"));
+    CHECK(wait_for_format(resolver, fclose_addr + 1, "fclose+0x1"));
+
+    // Names get demangled.
+    const auto dtor_addr = (uintptr_t)dlsym(RTLD_DEFAULT, "_ZNSt9exceptionD1Ev");
+    CHECK(dtor_addr != 0);
+    CHECK(wait_for_format(resolver, dtor_addr, "!std::exception::~exception()"));
+
+    dlclose(libc);
+}
+
+void test_load_generation() {
+    SymbolResolver resolver{};
+
+    // Part of glibc, but nothing here links it.
+    const auto handle = dlopen("libresolv.so.2", RTLD_NOW | RTLD_LOCAL);
+
+    if (handle == nullptr) {
+        std::fprintf(stderr, "Skipping load generation test, couldn't load libresolv: %s\n", dlerror());
+        return;
+    }
+
+    // Not in the snapshot yet, so nothing gets queued and the worker has to notice on its own.
+    const auto addr = (uintptr_t)((link_map*)handle)->l_ld;
+    CHECK(wait_for_format(resolver, addr, "libresolv.so.2+0x"));
+
+    dlclose(handle);
+}
+}
+
+int main() {
+    test_module_snapshot();
+    test_plain_map();
+    test_msvc_map();
+    test_set_modules_invalidation();
+    test_map_file_invalidation();
+    test_resolve_pending_batches();
+    test_dladdr();
+    test_load_generation();
+
+    if (tests::failures == 0) {
+        std::printf("All SymbolResolver tests passed\n");
+    }
+
+    return tests::failures;
+}